@@ -1,75 +1,590 @@
 #include "aoc/helpers.h"
+#include "aoc/arena.h"
+#include "aoc/bench.h"
+#include "aoc/parallel.h"
+#include "aoc/parse.h"
+#include "aoc/stream.h"
+#include "aoc/views.h"
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <limits>
+#include <map>
 #include <set>
+#include <tuple>
+#include <vector>
 
 namespace {
-  using Result = std::pair<int, int>;
+  using Result = std::pair<int64_t, int64_t>;
   using MappedFileSource = aoc::MappedFileSource<char>;
 
   constexpr std::string_view SampleInput(R"(R8, R4, R4, R8)");
   constexpr int SR_Part1 = 8;
   constexpr int SR_Part2 = 4;
 
-  const auto LoadInput = [](auto f) {
-    Result r{0, 0};
+  constexpr size_t None = std::numeric_limits<size_t>::max();
+
+  // A straight run of the walk, covering (x, y) + (dx, dy) * t for t in [1, length].
+  // The start point itself belongs to the previous run.
+  struct Move {
+    int64_t x, y;
+    int64_t dx, dy;
+    int64_t length;
+  };
+
+  // Axis aligned closed box of lattice points, either a line or a single point.
+  // Index is the position in the walk, the origin is 0 and move i is i + 1.
+  struct Segment {
+    int64_t x0, y0, x1, y1;
+    size_t index;
+
+    bool horizontal() const { return y0 == y1; }
+  };
+
+  const auto ToSegment = [](const Move& m, size_t index) {
+    const int64_t ax = m.x + m.dx, ay = m.y + m.dy;
+    const int64_t bx = m.x + m.dx * m.length, by = m.y + m.dy * m.length;
+    return Segment{ std::min(ax, bx), std::min(ay, by), std::max(ax, bx), std::max(ay, by), index };
+  };
+
+  // Point update, range minimum over [lo, hi)
+  class MinTree {
+  public:
+    explicit MinTree(size_t n)
+      : size_(1)
+    {
+      while (size_ < n) { size_ *= 2; }
+      tree_.assign(2 * size_, None);
+    }
+
+    void set(size_t i, size_t v) {
+      i += size_;
+      tree_[i] = v;
+      for (i /= 2; i > 0; i /= 2) {
+        tree_[i] = std::min(tree_[2 * i], tree_[2 * i + 1]);
+      }
+    }
+
+    size_t min(size_t lo, size_t hi) const {
+      size_t out = None;
+      for (lo += size_, hi += size_; lo < hi; lo /= 2, hi /= 2) {
+        if (lo & 1) { out = std::min(out, tree_[lo++]); }
+        if (hi & 1) { out = std::min(out, tree_[--hi]); }
+      }
+      return out;
+    }
+
+  private:
+    size_t size_;
+    std::vector<size_t> tree_;
+  };
+
+  // Index of the first segment in walk order that touches an earlier one, i.e.
+  // the minimum over all touching pairs of the later index, or None. The sweep
+  // structures, a set node per run, are all taken from arena.
+  const auto FirstCrossing = [](const aoc::ArenaVector<Segment>& segments, aoc::Arena& arena) {
+    size_t best = None;
+    const auto candidate = [&best](size_t a, size_t b) {
+      best = std::min(best, std::max(a, b));
+    };
+
+    aoc::ArenaVector<const Segment*> horizontal(&arena);
+    aoc::ArenaVector<const Segment*> vertical(&arena);
+    horizontal.reserve(segments.size());
+    vertical.reserve(segments.size());
+    for (const auto& s : segments) {
+      (s.horizontal() ? horizontal : vertical).push_back(&s);
+    }
+
+    // Vertical runs can only touch each other on the same column
+    std::sort(vertical.begin(), vertical.end(), [](const Segment* a, const Segment* b) {
+      return std::tie(a->x0, a->y0) < std::tie(b->x0, b->y0);
+    });
+    std::pmr::multiset<std::pair<int64_t, size_t>> ends(&arena);
+    std::pmr::multiset<size_t> open(&arena);
+    for (size_t i = 0; i < vertical.size(); i++) {
+      const auto* s = vertical[i];
+      if (i > 0 && vertical[i - 1]->x0 != s->x0) {
+        ends.clear();
+        open.clear();
+      }
+      while (!ends.empty() && ends.begin()->first < s->y0) {
+        open.erase(open.find(ends.begin()->second));
+        ends.erase(ends.begin());
+      }
+      if (!open.empty()) {
+        candidate(s->index, *open.begin());
+      }
+      ends.emplace(s->y1, s->index);
+      open.insert(s->index);
+    }
+
+    // Sweep columns left to right with the horizontal runs crossing the
+    // current column indexed by row. Opens sort before queries before closes,
+    // so touching end points count.
+    aoc::ArenaVector<int64_t> rows(&arena);
+    rows.reserve(horizontal.size());
+    for (const auto* s : horizontal) {
+      rows.push_back(s->y0);
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    const auto row = [&rows](int64_t y) {
+      return static_cast<size_t>(std::lower_bound(rows.begin(), rows.end(), y) - rows.begin());
+    };
+
+    enum EventType { Open = 0, Query = 1, Close = 2 };
+    struct Event {
+      int64_t x;
+      EventType type;
+      const Segment* s;
+    };
+    aoc::ArenaVector<Event> events(&arena);
+    events.reserve(horizontal.size() * 2 + vertical.size());
+    for (const auto* s : horizontal) {
+      events.push_back({ s->x0, Open, s });
+      events.push_back({ s->x1, Close, s });
+    }
+    for (const auto* s : vertical) {
+      events.push_back({ s->x0, Query, s });
+    }
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+      return std::tie(a.x, a.type) < std::tie(b.x, b.type);
+    });
 
-    std::set<aoc::Point> visited;
-    aoc::Point location{ 0 , 0 };
-    aoc::CardinalDirection heading = aoc::CardinalDirection::North;
-    std::string_view line;
-    DEBUG_LOG(location.first, location.second);
-    visited.emplace(location);
-    while (aoc::getline(f, line, ", ")) {
-      assert(line[0] == 'R' || line[0] == 'L');
-      auto d = aoc::stoi(line.substr(1));
-      switch (line[0]) {
-        case 'L':
-          heading = aoc::turnLeft(heading);
+    MinTree tree(rows.size());
+    aoc::ArenaVector<std::pmr::multiset<size_t>> active(rows.size(), &arena);
+    for (const auto& e : events) {
+      switch (e.type) {
+        case Open: {
+          auto& a = active[row(e.s->y0)];
+          if (!a.empty()) {
+            candidate(e.s->index, *a.begin());
+          }
+          a.insert(e.s->index);
+          tree.set(row(e.s->y0), *a.begin());
           break;
-        case 'R':
-          heading = aoc::turnRight(heading);
+        }
+        case Query: {
+          const size_t lo = row(e.s->y0);
+          const size_t hi = std::upper_bound(rows.begin(), rows.end(), e.s->y1) - rows.begin();
+          const size_t m = tree.min(lo, hi);
+          if (m != None) {
+            candidate(e.s->index, m);
+          }
+          break;
+        }
+        case Close: {
+          auto& a = active[row(e.s->y0)];
+          a.erase(a.find(e.s->index));
+          tree.set(row(e.s->y0), a.empty() ? None : *a.begin());
           break;
-        default:
-          throw std::runtime_error("Bad input: " + std::string(line));
+        }
       }
-      DEBUG_LOG(static_cast<int32_t>(heading), d);
-      while (d > 0) {
-        location = aoc::moveInDirection(location, heading, 1);
-        if (!visited.emplace(location).second && r.second == 0) {
-          r.second = std::abs(location.first) + std::abs(location.second);
+    }
+    return best;
+  };
+
+  // std::abs is not constexpr until C++23
+  constexpr int64_t Abs(int64_t v) {
+    return v < 0 ? -v : v;
+  }
+
+  constexpr int64_t NoHit = std::numeric_limits<int64_t>::max();
+
+  // Steps along m to the first point shared with any earlier segment
+  const auto FirstHit = [](const Move& m, const auto& segments, size_t index) {
+    const auto self = ToSegment(m, index);
+    int64_t best = NoHit;
+    for (const auto& s : segments) {
+      if (s.index >= index) { continue; }
+      const int64_t x0 = std::max(self.x0, s.x0), x1 = std::min(self.x1, s.x1);
+      const int64_t y0 = std::max(self.y0, s.y0), y1 = std::min(self.y1, s.y1);
+      if (x0 > x1 || y0 > y1) { continue; }
+      // Nearest end of the overlap, measured from the start of the move
+      const int64_t x = m.dx < 0 ? x1 : x0;
+      const int64_t y = m.dy < 0 ? y1 : y0;
+      best = std::min(best, Abs(x - m.x) + Abs(y - m.y));
+    }
+    return best;
+  };
+
+  // Instructions are packed as distance << 1 | turned right
+  using Instruction = uint64_t;
+
+  // Headings as quarter turns clockwise from north
+  constexpr int64_t Steps[4][2] = {
+    { 0, 1 },
+    { 1, 0 },
+    { 0, -1 },
+    { -1, 0 },
+  };
+
+  constexpr Instruction ParseInstruction(std::string_view token) {
+    int64_t d = 0;
+    if (token.size() < 2 || aoc::parse_token(token.data() + 1, token.size() - 1, d) != aoc::ParseStatus::Ok || d < 0 || (d >> 62)) {
+      throw std::runtime_error("Bad input: " + std::string(token));
+    }
+    if (token[0] != 'L' && token[0] != 'R') {
+      throw std::runtime_error("Bad input: " + std::string(token));
+    }
+    return static_cast<Instruction>(d) << 1 | (token[0] == 'R');
+  }
+
+  constexpr auto Tokens = [](std::string_view f) {
+    return aoc::split<',', ' ', '\r', '\n'>(f);
+  };
+
+  const auto ParseChunk = [](std::string_view f) {
+    std::vector<Instruction> out;
+    for (const auto token : Tokens(f)) {
+      out.push_back(ParseInstruction(token));
+    }
+    return out;
+  };
+
+  // The walk done one move at a time, checking each move against the
+  // earlier runs until the first revisit is found, after which only the
+  // position and heading are kept. Segments stores the runs: insert(segment)
+  // and first_hit(move), the distance along the move to the first point
+  // shared with a stored run or NoHit.
+  template <typename Segments>
+  class Walker {
+  public:
+    constexpr Walker() {
+      segments_.insert({ 0, 0, 0, 0, 0 });
+    }
+
+    constexpr void step(Instruction i) {
+      const int64_t d = i >> 1;
+      heading_ = (heading_ + ((i & 1) ? 1 : 3)) & 3;
+      if (d > 0 && !found_) {
+        const Move m{ x_, y_, Steps[heading_][0], Steps[heading_][1], d };
+        const int64_t t = segments_.first_hit(m);
+        if (t != NoHit) {
+          part2_ = Abs(m.x + m.dx * t) + Abs(m.y + m.dy * t);
+          found_ = true;
+          segments_ = Segments{};
+        } else {
+          segments_.insert(ToSegment(m, index_++));
         }
-        DEBUG_LOG(location.first, location.second);
-        d--;
       }
+      x_ += Steps[heading_][0] * d;
+      y_ += Steps[heading_][1] * d;
+    }
+
+    // Part 2 is 0 until found()
+    constexpr Result result() const { return { Abs(x_) + Abs(y_), part2_ }; }
+    constexpr bool found() const { return found_; }
+
+  private:
+    Segments segments_{};
+    size_t index_ = 1;
+    int heading_ = 0;
+    int64_t x_ = 0;
+    int64_t y_ = 0;
+    int64_t part2_ = 0;
+    bool found_ = false;
+  };
+
+  // Segment storage for constant expressions, checks every earlier run and
+  // throws past Capacity
+  template <size_t Capacity>
+  class FixedSegments {
+  public:
+    constexpr void insert(const Segment& s) {
+      if (size_ == items_.size()) {
+        throw std::runtime_error("Too many moves");
+      }
+      items_[size_++] = s;
+    }
+
+    constexpr int64_t first_hit(const Move& m) const {
+      return FirstHit(m, *this, size_);
+    }
+
+    constexpr const Segment* begin() const { return items_.data(); }
+    constexpr const Segment* end() const { return items_.data() + size_; }
+
+  private:
+    std::array<Segment, Capacity> items_{};
+    size_t size_ = 0;
+  };
+
+  // Runs in a constant expression, which keeps the sample answers a build
+  // time check
+  template <size_t Capacity>
+  constexpr Result SolveSmall(std::string_view f) {
+    Walker<FixedSegments<Capacity>> walk;
+    for (const auto token : Tokens(f)) {
+      walk.step(ParseInstruction(token));
+    }
+    return walk.result();
+  }
+
+  static_assert(SolveSmall<16>(SampleInput) == Result{ SR_Part1, SR_Part2 });
+
+  // Runs crossing a line, e.g. the vertical runs for moves along rows. A run
+  // covering lines [lo, hi] at position at is split into aligned power of two
+  // blocks of lines, as in a segment tree over all of int64, and each
+  // (level, block, at) is kept in one ordered set. The runs crossing a line
+  // are in the blocks holding it, one per level: a run of length L takes
+  // O(log L) entries and a query O(log L log n), with no bounds needed up front.
+  class CrossingSet {
+  public:
+    void insert(int64_t lo, int64_t hi, int64_t at) {
+      uint64_t a = Key(lo);
+      const uint64_t b = Key(hi);
+      for (;;) {
+        int level = 0;
+        while (level < 62 && !((a >> level) & 1) && b - a >= (uint64_t{2} << level) - 1) {
+          level++;
+        }
+        blocks_.emplace(level, a >> level, at);
+        levels_ = std::max(levels_, level + 1);
+        const uint64_t last = a + ((uint64_t{1} << level) - 1);
+        if (last == b) { break; }
+        a = last + 1;
+      }
+    }
+
+    // Position in [lo, hi] of the run crossing line nearest lo when
+    // ascending, else nearest hi, or NoHit
+    int64_t nearest(int64_t line, int64_t lo, int64_t hi, bool ascending) const {
+      const uint64_t k = Key(line);
+      int64_t best = NoHit;
+      for (int level = 0; level < levels_; level++) {
+        const uint64_t block = k >> level;
+        auto it = ascending ? blocks_.lower_bound({ level, block, lo }) : blocks_.upper_bound({ level, block, hi });
+        if (!ascending) {
+          if (it == blocks_.begin()) { continue; }
+          --it;
+        }
+        if (it == blocks_.end() || std::get<0>(*it) != level || std::get<1>(*it) != block) { continue; }
+        const int64_t at = std::get<2>(*it);
+        if (at < lo || at > hi) { continue; }
+        if (best == NoHit || (ascending ? at < best : at > best)) {
+          best = at;
+        }
+      }
+      return best;
+    }
+
+  private:
+    // Order preserving map to unsigned, so blocks are plain shifts
+    static uint64_t Key(int64_t v) {
+      return static_cast<uint64_t>(v) ^ (uint64_t{1} << 63);
+    }
+
+    std::set<std::tuple<int, uint64_t, int64_t>> blocks_;
+    int levels_ = 0;
+  };
+
+  // Earlier runs indexed by line, so a streamed move is checked in
+  // polylogarithmic time instead of against every earlier run. Until the
+  // first revisit no two runs share a point, so the runs along one line are
+  // disjoint intervals and the one starting last before a point is the only
+  // one that can cover it.
+  class SegmentIndex {
+  public:
+    void insert(const Segment& s) {
+      // The origin, the only single point, is filed as horizontal
+      if (s.horizontal()) {
+        along_[0].emplace(std::make_pair(s.y0, s.x0), s.x1);
+        across_[1].insert(s.x0, s.x1, s.y0);
+      } else {
+        along_[1].emplace(std::make_pair(s.x0, s.y0), s.y1);
+        across_[0].insert(s.y0, s.y1, s.x0);
+      }
+    }
+
+    int64_t first_hit(const Move& m) const {
+      const auto self = ToSegment(m, 0);
+      // Axis 0 moves along a row, axis 1 along a column
+      const int axis = m.dx != 0 ? 0 : 1;
+      const int64_t line = axis == 0 ? m.y : m.x;
+      const int64_t from = axis == 0 ? m.x : m.y;
+      const int64_t lo = axis == 0 ? self.x0 : self.y0;
+      const int64_t hi = axis == 0 ? self.x1 : self.y1;
+      const bool ascending = m.dx + m.dy > 0;
+
+      int64_t best = NoHit;
+      const auto take = [&](int64_t at) {
+        if (at != NoHit) { best = std::min(best, Abs(at - from)); }
+      };
+
+      const auto& runs = along_[axis];
+      const auto next = runs.upper_bound({ line, ascending ? lo : hi });
+      if (next != runs.begin()) {
+        const auto prev = std::prev(next);
+        if (prev->first.first == line && prev->second >= lo) {
+          take(ascending ? lo : std::min(prev->second, hi));
+        }
+      }
+      if (ascending && next != runs.end() && next->first.first == line && next->first.second <= hi) {
+        take(next->first.second);
+      }
+      take(across_[axis].nearest(line, lo, hi, ascending));
+      return best;
+    }
+
+  private:
+    // (line, start) to end of the runs along rows, then along columns
+    std::map<std::pair<int64_t, int64_t>, int64_t> along_[2];
+    // Runs crossing rows, then crossing columns
+    CrossingSet across_[2];
+  };
+
+  // Net effect of a run of instructions started facing north at the origin.
+  // Summaries compose: the second one is rotated by the first one's heading.
+  struct Summary {
+    int heading = 0;
+    int64_t x = 0;
+    int64_t y = 0;
+    size_t moves = 0;
+  };
+
+  const auto Rotate = [](int heading, int64_t& x, int64_t& y) {
+    for (int i = 0; i < heading; i++) {
+      const int64_t t = x;
+      x = y;
+      y = -t;
+    }
+  };
+
+  const auto Summarize = [](const std::vector<Instruction>& in) {
+    Summary s;
+    for (const auto i : in) {
+      const int64_t d = i >> 1;
+      s.heading = (s.heading + ((i & 1) ? 1 : 3)) & 3;
+      s.x += Steps[s.heading][0] * d;
+      s.y += Steps[s.heading][1] * d;
+      s.moves += d > 0;
+    }
+    return s;
+  };
+
+  // Replays a run from its true start, writing its moves from out onwards
+  const auto EmitMoves = [](const std::vector<Instruction>& in, Summary start, Move* out) {
+    int heading = start.heading;
+    int64_t x = start.x;
+    int64_t y = start.y;
+    for (const auto i : in) {
+      const int64_t d = i >> 1;
+      heading = (heading + ((i & 1) ? 1 : 3)) & 3;
+      DEBUG_LOG(heading, d);
+      if (d > 0) {
+        *out++ = { x, y, Steps[heading][0], Steps[heading][1], d };
+      }
+      x += Steps[heading][0] * d;
+      y += Steps[heading][1] * d;
+    }
+  };
+
+  // Headings are a prefix sum of turns mod 4 and positions a prefix sum of
+  // displacements, so the walk is a two pass parallel scan: chunks summarise
+  // themselves in their own frame, a short scan over the summaries gives each
+  // chunk its true start, and the chunks then replay themselves into place.
+  // The segment sweep for part 2 then runs over the assembled moves, so time
+  // and memory stay O(n log n) and O(n) in the number of instructions.
+  const auto LoadInput = [](auto f) {
+    PROFILE_ZONE("LoadInput");
+    Result r{0, 0};
+    // Everything sized by the walk lives here and goes in one unmap per block
+    aoc::Arena arena(aoc::ArenaOptions{ 1 << 20, true });
+
+    aoc::SplitOptions opts;
+    opts.delimiter = ',';
+    const auto chunks = aoc::split_records(f, opts);
+    const auto parsed = aoc::parallel_map(chunks, ParseChunk);
+    const auto summaries = aoc::parallel_map(parsed, Summarize);
+
+    std::vector<Summary> starts;
+    Summary at;
+    for (const auto& s : summaries) {
+      starts.push_back(at);
+      int64_t x = s.x;
+      int64_t y = s.y;
+      Rotate(at.heading, x, y);
+      at.x += x;
+      at.y += y;
+      at.heading = (at.heading + s.heading) & 3;
+      at.moves += s.moves;
+    }
+    r.first = std::abs(at.x) + std::abs(at.y);
+
+    aoc::ArenaVector<Move> moves(at.moves, &arena);
+    aoc::parallel_for(0, parsed.size(), [&](size_t i) {
+      EmitMoves(parsed[i], starts[i], moves.data() + starts[i].moves);
+    }, 1);
+
+    aoc::ArenaVector<Segment> segments(&arena);
+    segments.reserve(moves.size() + 1);
+    segments.push_back({ 0, 0, 0, 0, 0 });
+    for (size_t i = 0; i < moves.size(); i++) {
+      segments.push_back(ToSegment(moves[i], i + 1));
+    }
+
+    const size_t first = FirstCrossing(segments, arena);
+    if (first != None) {
+      const auto& m = moves[first - 1];
+      const int64_t t = FirstHit(m, segments, first);
+      r.second = std::abs(m.x + m.dx * t) + std::abs(m.y + m.dy * t);
+      DEBUG_LOG(first, t);
     }
-    r.first = std::abs(location.first) + std::abs(location.second);
     return r;
   };
+
+  // Instructions as they arrive. Until the first revisit every run walked is
+  // kept, indexed so each move costs O(log^2 n); after it memory is constant.
+  const auto StreamInput = [](const char* path, const aoc::StreamOptions& opts) {
+    aoc::BlockReader in(path);
+    Walker<SegmentIndex> walk;
+    aoc::stream_records(in, aoc::delimiters<',', ' ', '\r', '\n'>, opts, [&walk](std::string_view token) {
+      walk.step(ParseInstruction(token));
+    }, [&walk](size_t records) {
+      const auto r = walk.result();
+      aoc::print_running(records, r.first, walk.found() ? std::to_string(r.second) : "-");
+    });
+    return walk.result();
+  };
 }
 
-int main(int argc, char** argv) {
+AOC_MAIN(int argc, char** argv) {
   aoc::AutoTimer t;
+  const auto bench = aoc::parse_bench_options(argc, argv);
+  const auto stream = aoc::parse_stream_options(argc, argv);
   const bool inTest = argc < 2;
 
   Result r;
   if (inTest) {
     r = LoadInput(SampleInput);
+  } else if (stream.enabled) {
+    r = StreamInput(argv[1], stream);
   } else {
-    std::unique_ptr<MappedFileSource>m(new MappedFileSource(argc, argv));
-    std::string_view f(m->data(), m->size());
+    MappedFileSource m(argc, argv);
+    std::string_view f(m.data(), m.size());
+    t.set_bytes(f.size());
+    if (bench.enabled) {
+      aoc::run_benchmark(aoc::bench_name(argv[0]), bench, f.size(), [&f]() { return LoadInput(f); });
+    }
     r = LoadInput(f);
   }
 
-  int part1 = 0;
-  int part2 = 0;
+  int64_t part1 = 0;
+  int64_t part2 = 0;
 
   std::tie(part1, part2) = r;
 
   aoc::print_results(part1, part2);
 
+#if !defined(NDEBUG)
+  // The sample is checked at compile time, this covers the production path
   if (inTest) {
     aoc::assert_result(part1, SR_Part1);
     aoc::assert_result(part2, SR_Part2);
   }
+#endif
 
   return 0;
 }
@@ -1,125 +1,482 @@
 #include "aoc/helpers.h"
+#include "aoc/bench.h"
+#include "aoc/grid.h"
+#include "aoc/parallel.h"
+#include "aoc/simd.h"
+#include "aoc/views.h"
+#include <array>
 #include <vector>
 
 namespace {
-  using Result = std::pair<int, std::string>;
+  // The codes of both keypads, one key per line. Part 1 is kept as text as
+  // well, as an int overflows past nine lines
+  using Result = std::pair<std::string, std::string>;
   using MappedFileSource = aoc::MappedFileSource<char>;
 
   constexpr std::string_view SampleInput(R"(ULL
 RRDDD
 LURDL
 UUUUD)");
-  constexpr int SR_Part1 = 1985;
+  constexpr std::string_view SR_Part1{"1985"};
   constexpr std::string_view SR_Part2{"5DB3"};
 
-  const std::vector<std::vector<int8_t>> KeyPad{
-    { 7, 8, 9 },
-    { 4, 5, 6 },
-    { 1, 2, 3 },
-  };
+  // Keypads are drawn row by row, top row first, with a space where there is no key
+  STRING_CONSTANT(KeyPadLayout, "123\n"
+                                "456\n"
+                                "789");
+
+  STRING_CONSTANT(KeyPad2Layout, "  1  \n"
+                                 " 234 \n"
+                                 "56789\n"
+                                 " ABC \n"
+                                 "  D  ");
+
+  // A keypad compiled to a flat [state][input byte] -> state table. States
+  // [0, Capacity) are keys, Error is absorbing and is entered on any byte other
+  // than U, D, L or R, so stepping needs no branches or bounds checks.
+  template <size_t Capacity>
+  struct KeypadAutomaton {
+    static_assert(Capacity < 255, "states must fit in a byte");
+    static constexpr uint8_t Error = Capacity;
 
-  const std::vector<std::vector<int8_t>> KeyPad2{
-    { 0, 0, 'D', 0, 0 },
-    { 0, 'A', 'B', 'C', 0 },
-    { '5', '6', '7', '8', '9' },
-    { 0, '2', '3', '4', 0 },
-    { 0, 0, '1', 0, 0 },
+    std::array<std::array<uint8_t, 256>, Capacity + 1> next{};
+    std::array<char, Capacity> label{};
+    size_t keys = 0;
+    uint8_t start = Error;
+
+    constexpr uint8_t step(uint8_t state, char c) const {
+      return next[state][static_cast<uint8_t>(c)];
+    }
   };
 
+  constexpr size_t CountKeys(std::string_view layout) {
+    size_t n = 0;
+    for (const char c : layout) {
+      n += c != ' ' && c != '\n';
+    }
+    return n;
+  }
+
+  // Usable both in constant expressions and on layouts read at runtime; a bad
+  // layout throws, which is a compile error when evaluated as constexpr
+  template <size_t Capacity>
+  constexpr KeypadAutomaton<Capacity> CompileKeypad(std::string_view layout, char start) {
+    using Automaton = KeypadAutomaton<Capacity>;
+    Automaton kp;
+    if (CountKeys(layout) > Capacity) {
+      throw std::runtime_error("Keypad layout has too many keys");
+    }
+
+    std::array<int, Capacity> row{};
+    std::array<int, Capacity> col{};
+    int r = 0;
+    int c = 0;
+    for (const char ch : layout) {
+      if (ch == '\n') {
+        r++;
+        c = 0;
+        continue;
+      }
+      if (ch != ' ') {
+        if (ch == start) { kp.start = kp.keys; }
+        row[kp.keys] = r;
+        col[kp.keys] = c;
+        kp.label[kp.keys] = ch;
+        kp.keys++;
+      }
+      c++;
+    }
+    if (kp.start == Automaton::Error) {
+      throw std::runtime_error("Keypad layout has no start key");
+    }
+
+    const auto find = [&](int fr, int fc, uint8_t fallback) {
+      for (size_t k = 0; k < kp.keys; k++) {
+        if (row[k] == fr && col[k] == fc) { return static_cast<uint8_t>(k); }
+      }
+      return fallback;
+    };
+
+    for (size_t s = 0; s <= Capacity; s++) {
+      for (auto& n : kp.next[s]) { n = Automaton::Error; }
+    }
+    for (size_t k = 0; k < kp.keys; k++) {
+      const uint8_t self = static_cast<uint8_t>(k);
+      kp.next[k]['U'] = find(row[k] - 1, col[k], self);
+      kp.next[k]['D'] = find(row[k] + 1, col[k], self);
+      kp.next[k]['L'] = find(row[k], col[k] - 1, self);
+      kp.next[k]['R'] = find(row[k], col[k] + 1, self);
+    }
+    return kp;
+  }
+
+  // Every keypad, built in or loaded, starts on this key
+  constexpr char StartKey = '5';
+
+  constexpr auto KeyPad = CompileKeypad<CountKeys(KeyPadLayout)>(KeyPadLayout, StartKey);
+  constexpr auto KeyPad2 = CompileKeypad<CountKeys(KeyPad2Layout)>(KeyPad2Layout, StartKey);
 
-  enum class Direction {
-    Up = 0,
-    Down,
-    Left,
-    Right,
+  // Runtime layouts all share one capacity so they have a single table type
+  constexpr size_t MaxRuntimeKeys = 64;
+  using RuntimeKeypad = KeypadAutomaton<MaxRuntimeKeys>;
+
+  constexpr std::pair<char, aoc::CardinalDirection> Moves[] = {
+    { 'U', aoc::CardinalDirection::North },
+    { 'D', aoc::CardinalDirection::South },
+    { 'L', aoc::CardinalDirection::West },
+    { 'R', aoc::CardinalDirection::East },
   };
 
-  const auto ParseDirection = [](char c) {
-    switch (c) {
-      case 'U':
-        return Direction::Up;
-      case 'D':
-        return Direction::Down;
-      case 'L':
-        return Direction::Left;
-      case 'R':
-        return Direction::Right;
-      default:
-        throw std::runtime_error("Bad input: " + std::string(1, c));
+  // Layouts read at runtime are walked as a grid of states bordered with
+  // Error, so a move off the pad or into a gap reads Error and stays put
+  const auto LoadKeypad = [](std::string_view layout, char start) {
+    if (CountKeys(layout) > MaxRuntimeKeys) {
+      throw std::runtime_error("Keypad layout has too many keys");
+    }
+    const auto keys = aoc::parse_grid(layout);
+    aoc::Grid<uint8_t> state(keys.width(), keys.height(), RuntimeKeypad::Error, 1, RuntimeKeypad::Error);
+
+    RuntimeKeypad kp;
+    keys.for_each([&](aoc::Point p) {
+      const char ch = keys[p];
+      if (ch == ' ') { return; }
+      if (ch == start) { kp.start = kp.keys; }
+      state[p] = kp.keys;
+      kp.label[kp.keys++] = ch;
+    });
+    if (kp.start == RuntimeKeypad::Error) {
+      throw std::runtime_error("Keypad layout has no start key");
     }
+
+    for (auto& n : kp.next) { n.fill(RuntimeKeypad::Error); }
+    state.for_each([&](aoc::Point p) {
+      const uint8_t self = state[p];
+      if (self == RuntimeKeypad::Error) { return; }
+      for (const auto& [c, dir] : Moves) {
+        const uint8_t to = state.neighbour(p, dir);
+        kp.next[self][static_cast<uint8_t>(c)] = to == RuntimeKeypad::Error ? self : to;
+      }
+    });
+    return kp;
   };
 
-  aoc::Point Steps[] = {
-    { 0, 1 },
-    { 0, -1 },
-    { -1, 0 },
-    { 1, 0 },
+  // Every line is a function from keypad state to keypad state, and these
+  // compose associatively. StateMap holds one such function for both keypads at
+  // once, keypad 1 in bytes 0-15 and keypad 2 in bytes 16-31, so applying a byte
+  // to every start state is a single in-lane byte shuffle.
+  static_assert(KeyPad.Error < 16 && KeyPad2.Error < 16, "keypad states must fit a shuffle lane");
+
+  struct alignas(32) StateMap {
+    std::array<uint8_t, 32> s{};
+
+    uint8_t first(uint8_t state) const { return s[state]; }
+    uint8_t second(uint8_t state) const { return s[16 + state]; }
   };
 
-  const auto LoadInput = [](auto f) {
-    Result r{0, ""};
-    std::string_view line;
-    aoc::Point pos = { 1, 1 };
-    aoc::Point pos2 = { 0, 2 };
-    while (aoc::getline(f, line)) {
-      for (const auto c : line) {
-        assert(c == 'U' || c == 'D' || c == 'L' || c == 'R');
-        const auto dir = ParseDirection(c);
-        pos += Steps[static_cast<int>(dir)];
-        const auto last = pos2;
-        pos2 += Steps[static_cast<int>(dir)];
+  constexpr StateMap MakeStateMap(char c) {
+    StateMap m;
+    for (uint8_t i = 0; i < 16; i++) {
+      const bool linebreak = c == '\n' || c == '\r';
+      m.s[i] = linebreak ? i : KeyPad.step(std::min(i, KeyPad.Error), c);
+      m.s[16 + i] = linebreak ? i : KeyPad2.step(std::min(i, KeyPad2.Error), c);
+    }
+    return m;
+  }
 
-        pos.second = std::max(std::min(pos.second, (int)(KeyPad.size()) - 1), 0);
-        pos.first = std::max(std::min(pos.first, (int)(KeyPad.at(pos.second).size()) - 1), 0);
+  constexpr std::array<StateMap, 256> MakeByteMaps() {
+    std::array<StateMap, 256> out{};
+    for (size_t c = 0; c < 256; c++) {
+      out[c] = MakeStateMap(static_cast<char>(c));
+    }
+    return out;
+  }
+
+  constexpr auto ByteMaps = MakeByteMaps();
+  constexpr auto Identity = MakeStateMap('\n');
 
-        pos2.second = std::max(std::min(pos2.second, (int)(KeyPad2.size()) - 1), 0);
-        pos2.first = std::max(std::min(pos2.first, (int)(KeyPad2.at(pos2.second).size()) - 1), 0);
+  // Inputs below this size are stepped sequentially
+  constexpr size_t ParallelThreshold = 1 << 20;
+  constexpr size_t MinChunkBytes = 1 << 18;
 
-        if (KeyPad2.at(pos2.second).at(pos2.first) == 0) {
-          pos2 = last;
+  // What one chunk of bytes does to every possible start state. Line breaks
+  // record the map so far; the first break has to wait for the previous chunks
+  // to know whether it ends a line or a run of blank lines.
+  struct ChunkScan {
+    std::vector<StateMap> ends;
+    StateMap first;
+    bool conditional = false;
+    bool breaks = false;
+    bool trailing = false;
+    StateMap total;
+  };
+
+  const auto ScanChunk = [](std::string_view chunk) {
+    ChunkScan out;
+    bool chars = false;
+#if defined(AOC_HAVE_AVX2)
+    __m256i m = _mm256_load_si256(reinterpret_cast<const __m256i*>(Identity.s.data()));
+    const auto store = [&m](StateMap& to) {
+      _mm256_store_si256(reinterpret_cast<__m256i*>(to.s.data()), m);
+    };
+#else
+    StateMap m = Identity;
+    const auto store = [&m](StateMap& to) { to = m; };
+#endif
+    for (const char c : chunk) {
+      if (c == '\n' || c == '\r') {
+        if (chars) {
+          store(out.ends.emplace_back());
+        } else if (!out.breaks) {
+          out.conditional = true;
+          store(out.first);
         }
-        DEBUG_LOG(pos2.first, pos2.second, KeyPad2.at(pos2.second).at(pos2.first));
+        out.breaks = true;
+        chars = false;
+        continue;
+      }
+      const auto& t = ByteMaps[static_cast<uint8_t>(c)];
+#if defined(AOC_HAVE_AVX2)
+      m = _mm256_shuffle_epi8(_mm256_load_si256(reinterpret_cast<const __m256i*>(t.s.data())), m);
+#else
+      for (size_t i = 0; i < 16; i++) {
+        m.s[i] = t.s[m.s[i]];
+        m.s[16 + i] = t.s[16 + m.s[16 + i]];
+      }
+#endif
+      chars = true;
+    }
+    store(out.total);
+    out.trailing = chars;
+    return out;
+  };
+
+  struct ChunkStart {
+    uint8_t pos;
+    uint8_t pos2;
+    // Characters since the last line break before this chunk
+    bool open;
+  };
 
-        assert(pos.second >= 0 && pos.second < (int)KeyPad.size());
-        assert(pos.first >= 0 && pos.first < (int)KeyPad.at(pos.second).size());
-        assert(pos2.second >= 0 && pos2.second < (int)KeyPad2.size());
-        assert(pos2.first >= 0 && pos2.first < (int)KeyPad2.at(pos2.second).size());
+  const auto EmitLines = [](const ChunkScan& scan, ChunkStart start) {
+    Result out;
+    const auto emit = [&](const StateMap& m) {
+      const uint8_t pos = m.first(start.pos);
+      const uint8_t pos2 = m.second(start.pos2);
+      if (pos == KeyPad.Error || pos2 == KeyPad2.Error) {
+        throw std::runtime_error("Bad input");
       }
-      DEBUG_LOG((int)KeyPad.at(pos.second).at(pos.first));
-      DEBUG_LOG(KeyPad2.at(pos2.second).at(pos2.first));
+      out.first.push_back(KeyPad.label[pos]);
+      out.second.push_back(KeyPad2.label[pos2]);
+    };
+    if (scan.conditional && start.open) {
+      emit(scan.first);
+    }
+    for (const auto& m : scan.ends) {
+      emit(m);
+    }
+    return out;
+  };
+
+  // Scans chunks in parallel, walks the start state across the chunk maps (a
+  // scan over a handful of entries), then resolves every line end in parallel
+  const auto LoadParallel = [](std::string_view f) {
+    const size_t n = std::max<size_t>(1, std::min(aoc::default_pool().size() * 4, f.size() / MinChunkBytes));
+    std::vector<ChunkScan> scans(n);
+    aoc::parallel_for(0, n, [&](size_t i) {
+      const size_t b = f.size() * i / n;
+      const size_t e = f.size() * (i + 1) / n;
+      scans[i] = ScanChunk(f.substr(b, e - b));
+    }, 1);
+
+    std::vector<ChunkStart> starts;
+    ChunkStart state{ KeyPad.start, KeyPad2.start, false };
+    for (const auto& scan : scans) {
+      starts.push_back(state);
+      state.pos = scan.total.first(state.pos);
+      state.pos2 = scan.total.second(state.pos2);
+      state.open = scan.breaks ? scan.trailing : (state.open || scan.trailing);
+    }
 
-      r.first *= 10;
-      r.first += KeyPad.at(pos.second).at(pos.first);
-      r.second.append(1, KeyPad2.at(pos2.second).at(pos2.first));
+    Result keys = aoc::parallel_reduce(0, scans.size(), Result{}, [&](size_t lo, size_t) {
+      return EmitLines(scans[lo], starts[lo]);
+    }, [](Result a, const Result& b) {
+      a.first += b.first;
+      a.second += b.second;
+      return a;
+    }, 1);
+    if (state.open) {
+      if (state.pos == KeyPad.Error || state.pos2 == KeyPad2.Error) {
+        throw std::runtime_error("Bad input");
+      }
+      keys.first.push_back(KeyPad.label[state.pos]);
+      keys.second.push_back(KeyPad2.label[state.pos2]);
+    }
+    return keys;
+  };
+
+  // Steps both keypads line by line, calling emit with the two keys pressed at
+  // the end of each line
+  template <typename Pad, typename Pad2, typename Emit>
+  constexpr void Walk(std::string_view f, const Pad& pad, const Pad2& pad2, Emit&& emit) {
+    uint8_t pos = pad.start;
+    uint8_t pos2 = pad2.start;
+    for (const auto line : aoc::lines(f)) {
+      for (const auto c : line) {
+        pos = pad.step(pos, c);
+        pos2 = pad2.step(pos2, c);
+      }
+      if (pos == pad.Error || pos2 == pad2.Error) {
+        throw std::runtime_error("Bad input: " + std::string(line));
+      }
+      emit(pad.label[pos], pad2.label[pos2]);
     }
+  }
+
+  // The sequential walk with the codes kept in fixed buffers instead of
+  // std::strings, so the sample answers are checked at compile time
+  template <size_t Capacity>
+  struct SmallResult {
+    std::array<char, Capacity> keys{};
+    std::array<char, Capacity> keys2{};
+    size_t size = 0;
+
+    constexpr std::string_view first() const { return { keys.data(), size }; }
+    constexpr std::string_view second() const { return { keys2.data(), size }; }
+  };
+
+  template <size_t Capacity>
+  constexpr SmallResult<Capacity> SolveSmall(std::string_view f) {
+    SmallResult<Capacity> r;
+    Walk(f, KeyPad, KeyPad2, [&r](char key, char key2) {
+      if (r.size == Capacity) {
+        throw std::runtime_error("Too many lines");
+      }
+      r.keys[r.size] = key;
+      r.keys2[r.size++] = key2;
+    });
+    return r;
+  }
+
+  static_assert(SolveSmall<8>(SampleInput).first() == SR_Part1);
+  static_assert(SolveSmall<8>(SampleInput).second() == SR_Part2);
+
+  template <typename Pad, typename Pad2>
+  Result LoadSequential(std::string_view f, const Pad& pad, const Pad2& pad2) {
+    Result r;
+    Walk(f, pad, pad2, [&r](char key, char key2) {
+      DEBUG_LOG(key, key2);
+      r.first.push_back(key);
+      r.second.push_back(key2);
+    });
     return r;
+  }
+
+  const auto LoadInput = [](auto f) {
+    PROFILE_ZONE("LoadInput");
+    if (f.size() >= ParallelThreshold) {
+      return LoadParallel(f);
+    }
+    return LoadSequential(f, KeyPad, KeyPad2);
+  };
+
+  // Solves with keypads read from a file rather than the puzzle's own: the
+  // part 1 layout, then after a blank line the part 2 layout, or a single
+  // layout used for both. Loaded tables have more states than the parallel
+  // scan's shuffle lanes hold, so these inputs are always walked in order.
+  const auto LoadWithKeypads = [](std::string_view f, std::string_view layouts) {
+    PROFILE_ZONE("LoadWithKeypads");
+    const size_t gap = layouts.find("\n\n");
+    const auto layout2 = gap == std::string_view::npos ? layouts : layouts.substr(gap + 2);
+    const auto pad = LoadKeypad(layouts.substr(0, gap), StartKey);
+    const auto pad2 = LoadKeypad(layout2, StartKey);
+    return LoadSequential(f, pad, pad2);
+  };
+
+  // Pulls --keypads=FILE out of argv, like parse_bench_options
+  const auto ParseKeypadsOption = [](int& argc, char** argv) {
+    constexpr std::string_view Flag{"--keypads="};
+    std::string path;
+    int out = 1;
+    for (int i = 1; i < argc; i++) {
+      const std::string_view arg(argv[i]);
+      if (arg.substr(0, Flag.size()) == Flag) {
+        path = std::string(arg.substr(Flag.size()));
+        if (path.empty()) {
+          throw std::runtime_error("Bad value for --keypads");
+        }
+      } else {
+        argv[out++] = argv[i];
+      }
+    }
+    argc = out;
+    argv[argc] = nullptr;
+    return path;
   };
 }
 
-int main(int argc, char** argv) {
+AOC_MAIN(int argc, char** argv) {
   aoc::AutoTimer t;
+  const auto bench = aoc::parse_bench_options(argc, argv);
+  const auto keypads = ParseKeypadsOption(argc, argv);
   const bool inTest = argc < 2;
 
+  MappedFileSource layouts;
+  if (!keypads.empty()) {
+    layouts = MappedFileSource(keypads.c_str());
+  }
+  const auto solve = [&keypads, &layouts](std::string_view f) {
+    if (keypads.empty()) {
+      return LoadInput(f);
+    }
+    return LoadWithKeypads(f, std::string_view(layouts.data(), layouts.size()));
+  };
+
   Result r;
   if (inTest) {
-    r = LoadInput(SampleInput);
+    r = solve(SampleInput);
   } else {
-    std::unique_ptr<MappedFileSource>m(new MappedFileSource(argc, argv));
-    std::string_view f(m->data(), m->size());
-    r = LoadInput(f);
+    MappedFileSource m(argc, argv);
+    std::string_view f(m.data(), m.size());
+    t.set_bytes(f.size());
+    if (bench.enabled) {
+      aoc::run_benchmark(aoc::bench_name(argv[0]), bench, f.size(), [&f, &solve]() { return solve(f); });
+    }
+    r = solve(f);
   }
 
-  int part1 = 0;
+  std::string part1;
   std::string part2;
 
   std::tie(part1, part2) = r;
 
   aoc::print_results(part1, part2);
 
-  if (inTest) {
+#if !defined(NDEBUG)
+  // The sample is checked at compile time, this covers the production path
+  if (inTest && keypads.empty()) {
     aoc::assert_result(part1, SR_Part1);
     aoc::assert_result(part2, SR_Part2);
+
+    // Tables built on the bordered grid have to match the constexpr compiler's
+    const auto check_tables = [](const auto& built, const RuntimeKeypad& loaded) {
+      bool same = built.keys == loaded.keys && built.start == loaded.start;
+      for (size_t k = 0; same && k < built.keys; k++) {
+        same = built.label[k] == loaded.label[k];
+        for (const auto& [c, dir] : Moves) {
+          same = same && built.step(k, c) == loaded.step(k, c);
+        }
+      }
+      aoc::assert_result(same, true);
+    };
+    check_tables(KeyPad, LoadKeypad(KeyPadLayout, StartKey));
+    check_tables(KeyPad2, LoadKeypad(KeyPad2Layout, StartKey));
+
+    // The puzzle's layouts loaded at runtime have to solve it the same way
+    const auto loaded = LoadWithKeypads(SampleInput, std::string(KeyPadLayout) + "\n\n" + std::string(KeyPad2Layout));
+    aoc::assert_result(loaded.first, SR_Part1);
+    aoc::assert_result(loaded.second, SR_Part2);
   }
+#endif
 
   return 0;
 }
@@ -1,8 +1,14 @@
 #include "aoc/helpers.h"
+#include "aoc/bench.h"
+#include "aoc/parallel.h"
+#include "aoc/parse.h"
+#include "aoc/stream.h"
+#include "aoc/views.h"
+#include <array>
 #include <vector>
 
 namespace {
-  using Result = std::pair<int, int>;
+  using Result = std::pair<int64_t, int64_t>;
   using MappedFileSource = aoc::MappedFileSource<char>;
 
   constexpr std::string_view SampleInput(R"(5 10 25
@@ -11,68 +17,274 @@ namespace {
   constexpr int SR_Part1 = 1;
   constexpr int SR_Part2 = 2;
 
-  const auto isValidTriangle = [](const std::vector<int>& t) {
-    assert(t.size() == 3);
-    return t.at(0) + t.at(1) > t.at(2) &&
-        t.at(1) + t.at(2) > t.at(0) &&
-        t.at(0) + t.at(2) > t.at(1);
-};
+  // Triangles are kept as three aligned columns of sides, one entry per input
+  // row. Columns are zero padded to a whole number of vector blocks; a triangle
+  // with a zero side can never be valid, so padding never changes a count.
+  using Column = std::vector<int32_t, aoc::simd::AlignedAllocator<int32_t>>;
+  constexpr size_t ColumnPadding = 48;
+  // Keeps any sum of two sides within int32_t
+  constexpr int64_t MaxSide = int64_t(1) << 30;
 
-  const auto LoadInput = [](auto f) {
+  struct Triangles {
+    Column a, b, c;
+    size_t rows = 0;
+  };
+
+  const auto isValidTriangle = [](int32_t a, int32_t b, int32_t c) -> int {
+    return (a + b > c) & (b + c > a) & (a + c > b);
+  };
+
+  // Both parts counted from sides fed one at a time. A row is three sides and
+  // part 2 needs three rows, so at most the two rows before the current one
+  // are held.
+  class TriangleCounter {
+  public:
+    constexpr void push(int64_t side) {
+      if (side <= -MaxSide || side >= MaxSide) {
+        throw std::runtime_error("Bad input: side out of range");
+      }
+      pending_[n_++] = static_cast<int32_t>(side);
+      if (n_ % 3 == 0) {
+        r_.first += isValidTriangle(pending_[n_ - 3], pending_[n_ - 2], pending_[n_ - 1]);
+      }
+      if (n_ == pending_.size()) {
+        const auto& p = pending_;
+        r_.second += isValidTriangle(p[0], p[3], p[6]) + isValidTriangle(p[1], p[4], p[7]) + isValidTriangle(p[2], p[5], p[8]);
+        n_ = 0;
+      }
+    }
+
+    constexpr Result result() const { return r_; }
+    // A row was cut short
+    constexpr bool partial() const { return n_ % 3 != 0; }
+
+  private:
+    std::array<int32_t, 9> pending_{};
+    size_t n_ = 0;
+    Result r_{0, 0};
+  };
+
+  constexpr auto Sides = [](std::string_view f) {
+    return aoc::as_ints(aoc::split<' ', '\t', '\r', '\n'>(f));
+  };
+
+  // Runs in a constant expression, so the sample answers are checked at
+  // compile time
+  constexpr Result SolveSmall(std::string_view f) {
+    TriangleCounter counter;
+    for (const auto side : Sides(f)) {
+      counter.push(side);
+    }
+    return counter.result();
+  }
+
+  static_assert(SolveSmall(SampleInput) == Result{ SR_Part1, SR_Part2 });
+
+  const auto ToColumns = [](const std::vector<int64_t>& sides) {
+    if (sides.size() % 3) {
+      throw std::runtime_error("Bad input: incomplete triangle");
+    }
+
+    Triangles t;
+    t.rows = sides.size() / 3;
+    const size_t padded = aoc::simd::round_up(t.rows, ColumnPadding);
+    t.a.resize(padded);
+    t.b.resize(padded);
+    t.c.resize(padded);
+    for (size_t row = 0; row < t.rows; row++) {
+      const int64_t* s = &sides[row * 3];
+      if (std::abs(s[0]) >= MaxSide || std::abs(s[1]) >= MaxSide || std::abs(s[2]) >= MaxSide) {
+        throw std::runtime_error("Bad input: side out of range on row " + std::to_string(row));
+      }
+      t.a[row] = s[0];
+      t.b[row] = s[1];
+      t.c[row] = s[2];
+    }
+    return t;
+  };
+
+#if defined(AOC_HAVE_AVX2)
+  int countValid(__m256i a, __m256i b, __m256i c) {
+    const __m256i ab = _mm256_cmpgt_epi32(_mm256_add_epi32(a, b), c);
+    const __m256i bc = _mm256_cmpgt_epi32(_mm256_add_epi32(b, c), a);
+    const __m256i ac = _mm256_cmpgt_epi32(_mm256_add_epi32(a, c), b);
+    const __m256i ok = _mm256_and_si256(ab, _mm256_and_si256(bc, ac));
+    return aoc::simd::popcount(_mm256_movemask_ps(_mm256_castsi256_ps(ok)));
+  }
+
+  __m256i load(const int32_t* p) {
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(p));
+  }
+
+  // Splits 24 consecutive sides into the first, second and third side of 8
+  // triangles: a 3x3 transpose of 8-lane blocks done with blends and permutes.
+  void deinterleave(const int32_t* p, __m256i& x, __m256i& y, __m256i& z) {
+    const __m256i v0 = load(p);
+    const __m256i v1 = load(p + 8);
+    const __m256i v2 = load(p + 16);
+
+    x = _mm256_blend_epi32(_mm256_blend_epi32(v0, v1, 0x92), v2, 0x24);
+    y = _mm256_blend_epi32(_mm256_blend_epi32(v0, v1, 0x24), v2, 0x49);
+    z = _mm256_blend_epi32(_mm256_blend_epi32(v0, v1, 0x49), v2, 0x92);
+
+    x = _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5));
+    y = _mm256_permutevar8x32_epi32(y, _mm256_setr_epi32(1, 4, 7, 2, 5, 0, 3, 6));
+    z = _mm256_permutevar8x32_epi32(z, _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7));
+  }
+#endif
+
+  // Part 1: row i is the triangle (a[i], b[i], c[i]), 16 triangles per step
+  const auto CountRows = [](const Triangles& t) {
+    const size_t n = t.a.size();
+    int64_t count = 0;
+#if defined(AOC_HAVE_AVX2)
+    for (size_t i = 0; i < n; i += 16) {
+      count += countValid(load(&t.a[i]), load(&t.b[i]), load(&t.c[i]));
+      count += countValid(load(&t.a[i + 8]), load(&t.b[i + 8]), load(&t.c[i + 8]));
+    }
+#else
+    for (size_t i = 0; i < n; i++) {
+      count += isValidTriangle(t.a[i], t.b[i], t.c[i]);
+    }
+#endif
+    return count;
+  };
+
+  // Part 2: every three rows of a column form a triangle, 16 triangles per step
+  const auto CountColumns = [](const Triangles& t) {
+    const size_t n = t.a.size();
+    int64_t count = 0;
+    for (const Column* col : { &t.a, &t.b, &t.c }) {
+      const int32_t* p = col->data();
+#if defined(AOC_HAVE_AVX2)
+      __m256i x, y, z;
+      for (size_t i = 0; i < n; i += 48) {
+        deinterleave(p + i, x, y, z);
+        count += countValid(x, y, z);
+        deinterleave(p + i + 24, x, y, z);
+        count += countValid(x, y, z);
+      }
+#else
+      for (size_t i = 0; i < n; i += 3) {
+        count += isValidTriangle(p[i], p[i + 1], p[i + 2]);
+      }
+#endif
+    }
+    return count;
+  };
+
+  const auto SolveChunk = [](std::string_view f) {
     Result r{0, 0};
-    std::string_view line;
-    std::vector<int> triangle;
-    std::vector<std::vector<int>> vtriangles;
-    triangle.reserve(3);
-    vtriangles.resize(3);
-    vtriangles.at(0).reserve(3);
-    vtriangles.at(1).reserve(3);
-    vtriangles.at(2).reserve(3);
-    while (aoc::getline(f, line)) {
-      triangle.clear();
-      aoc::parse_as_integers(line, " ", [&triangle](const int64_t v) {
-        triangle.push_back(v);
-      });
-
-      r.first += isValidTriangle(triangle);
-      for (size_t v = 0; v < 3; v++) {
-        auto &t = vtriangles.at(v);
-        t.push_back(triangle.at(v));
-
-        if (t.size() == 3) {
-          r.second += isValidTriangle(t);
-          t.clear();
-        }
+    std::vector<int64_t> sides;
+    {
+      PROFILE_ZONE("parse");
+      const auto parsed = aoc::parse_integers(f, sides);
+      if (!parsed) {
+        throw std::runtime_error("Bad input at offset " + std::to_string(parsed.offset) + ": " + aoc::to_string(parsed.status));
       }
     }
+
+    Triangles t;
+    {
+      PROFILE_ZONE("columns");
+      t = ToColumns(sides);
+    }
+
+    PROFILE_ZONE("solve");
+    r.first = CountRows(t);
+    r.second = CountColumns(t);
     return r;
   };
+
+  // Chunks hold whole groups of three rows so part 2 never straddles a split
+  const auto SolveSplit = [](std::string_view f, aoc::SplitOptions opts) {
+    opts.group = 3;
+    return aoc::parallel_reduce(f, opts, Result{0, 0}, SolveChunk, [](Result a, const Result& b) {
+      a.first += b.first;
+      a.second += b.second;
+      return a;
+    });
+  };
+
+  const auto LoadInput = [](auto f) {
+    PROFILE_ZONE("LoadInput");
+    return SolveSplit(f, aoc::SplitOptions{});
+  };
+
+  // Rows as they arrive, in constant memory
+  const auto StreamInput = [](const char* path, const aoc::StreamOptions& opts) {
+    aoc::BlockReader in(path);
+    TriangleCounter counter;
+    aoc::stream_records(in, aoc::delimiters<'\r', '\n'>, opts, [&counter](std::string_view line) {
+      for (const auto side : Sides(line)) {
+        counter.push(side);
+      }
+    }, [&counter](size_t records) {
+      aoc::print_running(records, counter.result().first, counter.result().second);
+    });
+    if (counter.partial()) {
+      throw std::runtime_error("Bad input: incomplete triangle");
+    }
+    return counter.result();
+  };
 }
 
-int main(int argc, char** argv) {
+AOC_MAIN(int argc, char** argv) {
   aoc::AutoTimer t;
+  const auto bench = aoc::parse_bench_options(argc, argv);
+  const auto stream = aoc::parse_stream_options(argc, argv);
   const bool inTest = argc < 2;
 
   Result r;
   if (inTest) {
     r = LoadInput(SampleInput);
+  } else if (stream.enabled) {
+    r = StreamInput(argv[1], stream);
   } else {
-    std::unique_ptr<MappedFileSource>m(new MappedFileSource(argc, argv));
-    std::string_view f(m->data(), m->size());
+    MappedFileSource m(argc, argv);
+    std::string_view f(m.data(), m.size());
+    t.set_bytes(f.size());
+    if (bench.enabled) {
+      aoc::run_benchmark(aoc::bench_name(argv[0]), bench, f.size(), [&f]() { return LoadInput(f); });
+    }
     r = LoadInput(f);
   }
 
-  int part1 = 0;
-  int part2 = 0;
+  int64_t part1 = 0;
+  int64_t part2 = 0;
 
   std::tie(part1, part2) = r;
 
   aoc::print_results(part1, part2);
 
+#if !defined(NDEBUG)
+  // The sample is checked at compile time, this covers the production path
   if (inTest) {
     aoc::assert_result(part1, SR_Part1);
     aoc::assert_result(part2, SR_Part2);
+
+    // Blank lines, LF and CRLF, must not shift the groups of three rows, so
+    // cutting into many chunks gives the same answers as one
+    std::string blanks;
+    uint32_t seed = 1;
+    for (int row = 0; row < 600; row++) {
+      if (row % 7 == 3) { blanks += row % 2 ? "\n" : "\r\n"; }
+      for (int side = 0; side < 3; side++) {
+        seed = seed * 1103515245 + 12345;
+        blanks += std::to_string(seed >> 16 & 511) + (side < 2 ? " " : "\n");
+      }
+    }
+    aoc::SplitOptions one;
+    one.chunks = 1;
+    aoc::SplitOptions many;
+    many.chunks = 8;
+    many.min_chunk_bytes = 1;
+    const auto expected = SolveSplit(blanks, one);
+    const auto split = SolveSplit(blanks, many);
+    aoc::assert_result(split.first, expected.first);
+    aoc::assert_result(split.second, expected.second);
   }
+#endif
 
   return 0;
 }
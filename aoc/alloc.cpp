@@ -0,0 +1,71 @@
+// Replacement global operator new and delete that feed aoc/alloc.h. Linked
+// into every binary when the AOC_ALLOC_STATS CMake option is on; replacement
+// functions have to be defined exactly once per program, so this is the one
+// part of the helpers that cannot live in a header.
+
+#include "aoc/alloc.h"
+
+#include <malloc.h>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+  void* Allocate(size_t n, size_t align) {
+    for (;;) {
+      void* p = nullptr;
+      if (align <= alignof(std::max_align_t)) {
+        p = std::malloc(n ? n : 1);
+      } else if (::posix_memalign(&p, align, n ? n : 1) != 0) {
+        p = nullptr;
+      }
+      if (p) {
+        aoc::detail::note_alloc(n, ::malloc_usable_size(p));
+        return p;
+      }
+      const auto handler = std::get_new_handler();
+      if (!handler) {
+        throw std::bad_alloc();
+      }
+      handler();
+    }
+  }
+
+  void* AllocateNoThrow(size_t n, size_t align) noexcept {
+    try {
+      return Allocate(n, align);
+    } catch (...) {
+      return nullptr;
+    }
+  }
+
+  void Free(void* p) noexcept {
+    if (!p) { return; }
+    aoc::detail::note_free(::malloc_usable_size(p));
+    std::free(p);
+  }
+
+  constexpr size_t DefaultAlign = alignof(std::max_align_t);
+}
+
+void* operator new(size_t n) { return Allocate(n, DefaultAlign); }
+void* operator new[](size_t n) { return Allocate(n, DefaultAlign); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return AllocateNoThrow(n, DefaultAlign); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return AllocateNoThrow(n, DefaultAlign); }
+void* operator new(size_t n, std::align_val_t a) { return Allocate(n, static_cast<size_t>(a)); }
+void* operator new[](size_t n, std::align_val_t a) { return Allocate(n, static_cast<size_t>(a)); }
+void* operator new(size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return AllocateNoThrow(n, static_cast<size_t>(a)); }
+void* operator new[](size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return AllocateNoThrow(n, static_cast<size_t>(a)); }
+
+void operator delete(void* p) noexcept { Free(p); }
+void operator delete[](void* p) noexcept { Free(p); }
+void operator delete(void* p, size_t) noexcept { Free(p); }
+void operator delete[](void* p, size_t) noexcept { Free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { Free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { Free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { Free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { Free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { Free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { Free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { Free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { Free(p); }
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Heap accounting, opt in with the AOC_ALLOC_STATS CMake option. That builds
+// aoc/alloc.cpp, which replaces the global operator new and delete, into every
+// binary and defines AOC_ALLOC_STATS so AutoTimer and the benchmark report
+// what they saw. Without it AllocScope still compiles but reads all zeros.
+//
+// Counters are process wide: nested scopes on one thread see the right
+// numbers, but scopes running concurrently (days in the runner) each count
+// every thread's allocations. Bytes are as requested; live and peak bytes are
+// as sized by malloc, since that is all delete can recover. Memory mapped
+// directly (Arena blocks, MappedFileSource) is not heap and is not counted.
+
+namespace aoc {
+
+#if defined(AOC_ALLOC_STATS)
+    constexpr bool alloc_stats_enabled = true;
+#else
+    constexpr bool alloc_stats_enabled = false;
+#endif
+
+    struct AllocStats {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t bytes = 0;
+        // Highest live heap seen, above what was live when the scope began
+        int64_t peak_bytes = 0;
+    };
+
+    namespace detail {
+
+        // Constant initialised, so allocations made during static
+        // initialisation are counted as well
+        struct AllocCounters {
+            std::atomic<uint64_t> allocations{0};
+            std::atomic<uint64_t> frees{0};
+            std::atomic<uint64_t> bytes{0};
+            std::atomic<int64_t> live{0};
+            std::atomic<int64_t> peak{0};
+        };
+
+        inline AllocCounters alloc_counters;
+
+        inline void note_alloc(size_t requested, size_t usable) {
+            auto& c = alloc_counters;
+            c.allocations.fetch_add(1, std::memory_order_relaxed);
+            c.bytes.fetch_add(requested, std::memory_order_relaxed);
+            const int64_t live = c.live.fetch_add(static_cast<int64_t>(usable), std::memory_order_relaxed) + static_cast<int64_t>(usable);
+            int64_t peak = c.peak.load(std::memory_order_relaxed);
+            while (live > peak && !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+        }
+
+        inline void note_free(size_t usable) {
+            auto& c = alloc_counters;
+            c.frees.fetch_add(1, std::memory_order_relaxed);
+            c.live.fetch_sub(static_cast<int64_t>(usable), std::memory_order_relaxed);
+        }
+
+    };
+
+    // Heap traffic between construction and read(). The peak is tracked by
+    // resetting the process peak to the current live bytes on entry and
+    // folding the scope's peak back in on exit, so enclosing scopes still see
+    // the highest point reached inside this one.
+    class AllocScope {
+    public:
+        AllocScope() {
+            saved_peak_ = begin();
+        }
+
+        ~AllocScope() {
+            restore_peak(saved_peak_);
+        }
+
+        // Starts counting afresh, the peak seen so far still reaches enclosing scopes
+        void reset() {
+            const int64_t peak = begin();
+            saved_peak_ = peak > saved_peak_ ? peak : saved_peak_;
+        }
+
+        AllocScope(const AllocScope&) = delete;
+        AllocScope& operator=(const AllocScope&) = delete;
+
+        AllocStats read() const {
+            const auto& c = detail::alloc_counters;
+            AllocStats s;
+            s.allocations = c.allocations.load(std::memory_order_relaxed) - start_.allocations;
+            s.frees = c.frees.load(std::memory_order_relaxed) - start_.frees;
+            s.bytes = c.bytes.load(std::memory_order_relaxed) - start_.bytes;
+            s.peak_bytes = c.peak.load(std::memory_order_relaxed) - base_;
+            return s;
+        }
+
+    private:
+        // Snapshots the counters and resets the process peak, returning the old one
+        int64_t begin() {
+            auto& c = detail::alloc_counters;
+            start_.allocations = c.allocations.load(std::memory_order_relaxed);
+            start_.frees = c.frees.load(std::memory_order_relaxed);
+            start_.bytes = c.bytes.load(std::memory_order_relaxed);
+            base_ = c.live.load(std::memory_order_relaxed);
+            return c.peak.exchange(base_, std::memory_order_relaxed);
+        }
+
+        static void restore_peak(int64_t saved) {
+            auto& c = detail::alloc_counters;
+            int64_t peak = c.peak.load(std::memory_order_relaxed);
+            while (saved > peak && !c.peak.compare_exchange_weak(peak, saved, std::memory_order_relaxed)) {}
+        }
+
+        AllocStats start_;
+        int64_t base_ = 0;
+        int64_t saved_peak_ = 0;
+    };
+
+    inline void print_alloc_stats(std::ostream& os, const AllocStats& s) {
+        os << "Allocations: " << s.allocations << " (" << s.bytes << " bytes), "
+            << s.frees << " frees, peak " << s.peak_bytes << " bytes live" << std::endl;
+    }
+
+};
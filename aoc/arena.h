@@ -0,0 +1,133 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace aoc {
+
+    struct ArenaOptions {
+        // Size of the first block, each later block is at least twice the last
+        size_t initial_bytes = 1 << 20;
+        // Ask for transparent huge pages on blocks of 2 MiB or more
+        bool huge_pages = false;
+    };
+
+    // Monotonic bump allocator for the lifetime of one solve. Memory comes from
+    // anonymous mappings and deallocate() is a no-op, everything is unmapped at
+    // once by release() or the destructor. Not thread safe, parallel tasks that
+    // want an arena should each make their own.
+    class Arena : public std::pmr::memory_resource {
+    public:
+        static constexpr size_t HugePageSize = 2 << 20;
+
+        explicit Arena(ArenaOptions opts = {})
+            : opts_(opts)
+            , next_(std::max<size_t>(opts.initial_bytes, 4096))
+        {}
+
+        ~Arena() override {
+            release();
+        }
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        // Containers using the arena must be gone first, node based ones walk
+        // their nodes on destruction
+        void release() {
+            while (head_) {
+                Block* prev = head_->prev;
+                ::munmap(head_, head_->size);
+                head_ = prev;
+            }
+            cur_ = end_ = 0;
+            used_ = mapped_ = 0;
+            next_ = std::max<size_t>(opts_.initial_bytes, 4096);
+        }
+
+        // Bytes handed out so far, and bytes mapped to serve them
+        size_t used() const { return used_; }
+        size_t mapped() const { return mapped_; }
+
+    private:
+        struct Block {
+            Block* prev;
+            size_t size;
+        };
+
+        void* do_allocate(size_t bytes, size_t align) override {
+            uintptr_t p = (cur_ + align - 1) & ~uintptr_t(align - 1);
+            if (p + bytes > end_ || p < cur_) {
+                grow(bytes + align);
+                p = (cur_ + align - 1) & ~uintptr_t(align - 1);
+            }
+            cur_ = p + bytes;
+            used_ += bytes;
+            return reinterpret_cast<void*>(p);
+        }
+
+        void do_deallocate(void*, size_t, size_t) override {}
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        void grow(size_t min_bytes) {
+            const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            size_t size = std::max(next_, min_bytes + sizeof(Block));
+            const bool huge = opts_.huge_pages && size >= HugePageSize;
+            const size_t align = huge ? HugePageSize : page;
+            size = (size + align - 1) / align * align;
+
+            // Huge pages need a 2 MiB aligned range, so over-map and trim
+            const size_t slack = huge ? HugePageSize : 0;
+            void* m = ::mmap(nullptr, size + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (m == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            uint8_t* base = static_cast<uint8_t*>(m);
+            if (huge) {
+                uint8_t* aligned = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(base) + HugePageSize - 1) & ~uintptr_t(HugePageSize - 1));
+                if (aligned > base) { ::munmap(base, aligned - base); }
+                if (aligned + size < base + size + slack) { ::munmap(aligned + size, base + size + slack - (aligned + size)); }
+                base = aligned;
+#ifdef MADV_HUGEPAGE
+                ::madvise(base, size, MADV_HUGEPAGE);
+#endif
+            }
+
+            head_ = new (base) Block{ head_, size };
+            cur_ = reinterpret_cast<uintptr_t>(head_ + 1);
+            end_ = reinterpret_cast<uintptr_t>(base) + size;
+            mapped_ += size;
+            next_ = size * 2;
+        }
+
+        ArenaOptions opts_;
+        size_t next_;
+        Block* head_ = nullptr;
+        uintptr_t cur_ = 0;
+        uintptr_t end_ = 0;
+        size_t used_ = 0;
+        size_t mapped_ = 0;
+    };
+
+    // Containers that take an Arena*, or any other memory resource, on construction
+    template <typename T>
+    using ArenaVector = std::pmr::vector<T>;
+
+    template <typename T, typename Hash = std::hash<T>, typename Eq = std::equal_to<T>>
+    using ArenaHashSet = std::pmr::unordered_set<T, Hash, Eq>;
+
+    using ArenaString = std::pmr::string;
+
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "helpers.h"
+
+namespace aoc {
+
+    struct BenchOptions {
+        bool enabled = false;
+        size_t warmup = 3;
+        size_t iterations = 20;
+        // JSON report goes to this file, or stdout when empty
+        std::string json;
+    };
+
+    // Pulls --bench, --warmup=N, --iterations=N and --json=FILE out of argv so
+    // the remaining arguments look exactly like a normal run
+    inline BenchOptions parse_bench_options(int& argc, char** argv) {
+        BenchOptions opts;
+        const auto value = [](std::string_view arg, std::string_view flag, std::string_view& out) {
+            if (arg.substr(0, flag.size()) != flag || arg.size() == flag.size() || arg[flag.size()] != '=') {
+                return false;
+            }
+            out = arg.substr(flag.size() + 1);
+            return true;
+        };
+        const auto count = [](std::string_view flag, std::string_view v) {
+            char* end = nullptr;
+            const std::string s(v);
+            const unsigned long long n = std::strtoull(s.c_str(), &end, 10);
+            if (s.empty() || *end) {
+                throw std::runtime_error("Bad value for " + std::string(flag) + ": " + s);
+            }
+            return static_cast<size_t>(n);
+        };
+
+        int out = 1;
+        for (int i = 1; i < argc; i++) {
+            const std::string_view arg(argv[i]);
+            std::string_view v;
+            if (arg == "--bench") {
+                opts.enabled = true;
+            } else if (value(arg, "--warmup", v)) {
+                opts.warmup = count("--warmup", v);
+            } else if (value(arg, "--iterations", v)) {
+                opts.iterations = std::max<size_t>(1, count("--iterations", v));
+            } else if (value(arg, "--json", v)) {
+                opts.json = std::string(v);
+            } else {
+                argv[out++] = argv[i];
+            }
+        }
+        argc = out;
+        argv[argc] = nullptr;
+        return opts;
+    }
+
+    // Forces value to be materialised, so the work producing it cannot be elided
+    template <typename T>
+    void do_not_optimize(const T& value) {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+
+    // Makes the compiler assume any memory may have changed, so inputs are
+    // re-read and loop invariant work is not hoisted out of the timed loop
+    inline void clobber_memory() {
+        asm volatile("" : : : "memory");
+    }
+
+    struct BenchStats {
+        size_t iterations = 0;
+        double min_ns = 0;
+        double median_ns = 0;
+        double p99_ns = 0;
+        double mean_ns = 0;
+        double stddev_ns = 0;
+    };
+
+    inline BenchStats summarize(std::vector<double> samples) {
+        BenchStats s;
+        if (samples.empty()) { return s; }
+        std::sort(samples.begin(), samples.end());
+
+        const size_t n = samples.size();
+        s.iterations = n;
+        s.min_ns = samples.front();
+        s.median_ns = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+        // Nearest rank
+        s.p99_ns = samples[static_cast<size_t>(std::ceil(0.99 * n)) - 1];
+
+        double sum = 0;
+        for (const auto v : samples) { sum += v; }
+        s.mean_ns = sum / n;
+
+        double var = 0;
+        for (const auto v : samples) { var += (v - s.mean_ns) * (v - s.mean_ns); }
+        s.stddev_ns = n > 1 ? std::sqrt(var / (n - 1)) : 0;
+        return s;
+    }
+
+    inline std::string bench_name(const char* argv0) {
+        const char* slash = std::strrchr(argv0, '/');
+        return slash ? slash + 1 : argv0;
+    }
+
+    // Times fn over opts.warmup discarded and opts.iterations measured runs and
+    // prints a text summary followed by a single line JSON object
+    template <typename F>
+    BenchStats run_benchmark(const std::string& name, const BenchOptions& opts, size_t bytes, F&& fn) {
+        for (size_t i = 0; i < opts.warmup; i++) {
+            clobber_memory();
+            do_not_optimize(fn());
+        }
+
+        std::vector<double> samples;
+        samples.reserve(opts.iterations);
+        AllocScope allocs;
+        for (size_t i = 0; i < opts.iterations; i++) {
+            clobber_memory();
+            const auto start = std::chrono::steady_clock::now();
+            do_not_optimize(fn());
+            const auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+
+        const auto heap = allocs.read();
+        const auto s = summarize(std::move(samples));
+        const double mbps = s.median_ns > 0 ? bytes / (s.median_ns * 1e-9) / (1 << 20) : 0;
+
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(3)
+            << "Bench " << name << ": " << s.iterations << " iterations (" << opts.warmup << " warmup), " << bytes << " bytes" << std::endl
+            << "  min:    " << s.min_ns * 1e-6 << " ms" << std::endl
+            << "  median: " << s.median_ns * 1e-6 << " ms (" << mbps << " MiB/s)" << std::endl
+            << "  p99:    " << s.p99_ns * 1e-6 << " ms" << std::endl
+            << "  stddev: " << s.stddev_ns * 1e-6 << " ms" << std::endl;
+        if (alloc_stats_enabled) {
+            text << std::setprecision(1)
+                << "  heap:   " << static_cast<double>(heap.allocations) / s.iterations << " allocations, "
+                << static_cast<double>(heap.bytes) / s.iterations << " bytes per iteration, peak " << heap.peak_bytes << " bytes live" << std::endl;
+        }
+        out() << text.str();
+
+        std::ostringstream json;
+        json << std::fixed << std::setprecision(0)
+            << "{\"name\":\"" << name << "\""
+            << ",\"bytes\":" << bytes
+            << ",\"warmup\":" << opts.warmup
+            << ",\"iterations\":" << s.iterations
+            << ",\"min_ns\":" << s.min_ns
+            << ",\"median_ns\":" << s.median_ns
+            << ",\"p99_ns\":" << s.p99_ns
+            << ",\"mean_ns\":" << s.mean_ns
+            << ",\"stddev_ns\":" << s.stddev_ns;
+        if (alloc_stats_enabled) {
+            json << ",\"allocations\":" << heap.allocations
+                << ",\"alloc_bytes\":" << heap.bytes
+                << ",\"peak_heap_bytes\":" << heap.peak_bytes;
+        }
+        json << "}";
+
+        if (opts.json.empty()) {
+            out() << json.str() << std::endl;
+        } else {
+            std::ofstream f(opts.json);
+            f << json.str() << std::endl;
+            if (!f) { throw std::runtime_error("Unable to write " + opts.json); }
+        }
+        return s;
+    }
+
+};
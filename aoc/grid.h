@@ -0,0 +1,226 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "helpers.h"
+#include "simd.h"
+#include "views.h"
+
+namespace aoc {
+
+    constexpr std::array<CardinalDirection, 4> CardinalDirections = {
+        CardinalDirection::North,
+        CardinalDirection::East,
+        CardinalDirection::South,
+        CardinalDirection::West,
+    };
+
+    // Contiguous run of cells, e.g. one row of a grid
+    template <typename T>
+    class GridSpan {
+    public:
+        GridSpan(T* data, size_t size)
+            : data_(data)
+            , size_(size)
+        {}
+
+        T* begin() const { return data_; }
+        T* end() const { return data_ + size_; }
+        size_t size() const { return size_; }
+        T& operator[](size_t i) const { return data_[i]; }
+
+    private:
+        T* data_;
+        size_t size_;
+    };
+
+    // Cells stride apart in memory, e.g. one column of a grid
+    template <typename T>
+    class StridedSpan {
+    public:
+        StridedSpan(T* data, size_t size, ptrdiff_t stride)
+            : data_(data)
+            , size_(size)
+            , stride_(stride)
+        {}
+
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::remove_const_t<T>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = T*;
+            using reference = T&;
+
+            iterator(T* p, ptrdiff_t stride)
+                : p_(p)
+                , stride_(stride)
+            {}
+
+            T& operator*() const { return *p_; }
+            iterator& operator++() {
+                p_ += stride_;
+                return *this;
+            }
+            bool operator==(const iterator& o) const { return p_ == o.p_; }
+            bool operator!=(const iterator& o) const { return p_ != o.p_; }
+
+        private:
+            T* p_;
+            ptrdiff_t stride_;
+        };
+
+        iterator begin() const { return iterator(data_, stride_); }
+        iterator end() const { return iterator(data_ + stride_ * static_cast<ptrdiff_t>(size_), stride_); }
+        size_t size() const { return size_; }
+        T& operator[](size_t i) const { return data_[stride_ * static_cast<ptrdiff_t>(i)]; }
+
+    private:
+        T* data_;
+        size_t size_;
+        ptrdiff_t stride_;
+    };
+
+    // Dense 2D grid in one row-major, cache line aligned buffer. Cells are
+    // addressed by Point in screen order: x is the column, y the row, row 0 is
+    // the top line and North is the row above. The grid can carry a border of
+    // sentinel cells on every side, and operator[] accepts points up to border
+    // cells outside the grid, so a walk that stops on the sentinel needs no
+    // bounds checks for neighbours.
+    template <typename T>
+    class Grid {
+    public:
+        static_assert(!std::is_same_v<T, bool>, "use uint8_t, vector<bool> is not contiguous");
+
+        Grid() = default;
+
+        Grid(size_t width, size_t height, const T& fill = T{}, size_t border = 0, const T& sentinel = T{})
+            : width_(width)
+            , height_(height)
+            , border_(border)
+            , stride_(width + 2 * border)
+            , cells_(stride_ * (height + 2 * border), sentinel)
+        {
+            origin_ = static_cast<ptrdiff_t>(border_ * stride_ + border_);
+            for (size_t y = 0; y < height_; y++) {
+                const auto r = row(y);
+                std::fill(r.begin(), r.end(), fill);
+            }
+        }
+
+        // One row per non-empty line of block, top line first, each byte
+        // converted with cell(char). Lines shorter than the longest are padded
+        // with fill.
+        template <typename F>
+        static Grid parse(std::string_view block, F&& cell, const T& fill = T{}, size_t border = 0, const T& sentinel = T{}) {
+            size_t width = 0;
+            size_t height = 0;
+            for (const auto line : lines(block)) {
+                width = std::max(width, line.size());
+                height++;
+            }
+
+            Grid g(width, height, fill, border, sentinel);
+            size_t y = 0;
+            for (const auto line : lines(block)) {
+                T* r = g.row_data(y++);
+                for (const char c : line) {
+                    *r++ = cell(c);
+                }
+            }
+            return g;
+        }
+
+        size_t width() const { return width_; }
+        size_t height() const { return height_; }
+        size_t border() const { return border_; }
+        // Distance between vertically adjacent cells
+        size_t stride() const { return stride_; }
+
+        bool contains(const Point& p) const {
+            return p.x >= 0 && p.y >= 0 && static_cast<size_t>(p.x) < width_ && static_cast<size_t>(p.y) < height_;
+        }
+
+        // Unchecked, p may be up to border() cells outside the grid
+        T& operator[](const Point& p) { return cells_[index(p)]; }
+        const T& operator[](const Point& p) const { return cells_[index(p)]; }
+
+        T& at(const Point& p) { return cells_[checked(p)]; }
+        const T& at(const Point& p) const { return cells_[checked(p)]; }
+
+        // Cell offsets, for walks that keep a flat index instead of a Point
+        ptrdiff_t index(const Point& p) const {
+            return origin_ + static_cast<ptrdiff_t>(p.y) * static_cast<ptrdiff_t>(stride_) + p.x;
+        }
+
+        ptrdiff_t offset(CardinalDirection dir) const {
+            const Point s = step(dir);
+            return static_cast<ptrdiff_t>(s.y) * static_cast<ptrdiff_t>(stride_) + s.x;
+        }
+
+        T* row_data(size_t y) { return cells_.data() + index({ 0, static_cast<int32_t>(y) }); }
+        const T* row_data(size_t y) const { return cells_.data() + index({ 0, static_cast<int32_t>(y) }); }
+
+        GridSpan<T> row(size_t y) { return { row_data(y), width_ }; }
+        GridSpan<const T> row(size_t y) const { return { row_data(y), width_ }; }
+
+        StridedSpan<T> column(size_t x) {
+            return { cells_.data() + index({ static_cast<int32_t>(x), 0 }), height_, static_cast<ptrdiff_t>(stride_) };
+        }
+        StridedSpan<const T> column(size_t x) const {
+            return { cells_.data() + index({ static_cast<int32_t>(x), 0 }), height_, static_cast<ptrdiff_t>(stride_) };
+        }
+
+        // Unit step in screen order; stepFromCardinalDirection has North as +y
+        static constexpr Point step(CardinalDirection dir) {
+            const Point s = stepFromCardinalDirection(dir);
+            return { s.x, -s.y };
+        }
+
+        static constexpr Point move(const Point& p, CardinalDirection dir, int32_t steps = 1) {
+            return p + step(dir) * steps;
+        }
+
+        T& neighbour(const Point& p, CardinalDirection dir) { return (*this)[move(p, dir)]; }
+        const T& neighbour(const Point& p, CardinalDirection dir) const { return (*this)[move(p, dir)]; }
+
+        // Every point of the grid, row by row
+        template <typename F>
+        void for_each(F&& fn) const {
+            for (size_t y = 0; y < height_; y++) {
+                for (size_t x = 0; x < width_; x++) {
+                    fn(Point{ static_cast<int32_t>(x), static_cast<int32_t>(y) });
+                }
+            }
+        }
+
+    private:
+        ptrdiff_t checked(const Point& p) const {
+            const int64_t b = static_cast<int64_t>(border_);
+            if (p.x < -b || p.y < -b || p.x >= static_cast<int64_t>(width_) + b || p.y >= static_cast<int64_t>(height_) + b) {
+                throw std::runtime_error("Grid index out of range");
+            }
+            return index(p);
+        }
+
+        size_t width_ = 0;
+        size_t height_ = 0;
+        size_t border_ = 0;
+        size_t stride_ = 0;
+        ptrdiff_t origin_ = 0;
+        std::vector<T, simd::AlignedAllocator<T, 64>> cells_;
+    };
+
+    // Character grid from a block of text, padded and bordered with pad
+    inline Grid<char> parse_grid(std::string_view block, size_t border = 0, char pad = ' ') {
+        return Grid<char>::parse(block, [](char c) { return c; }, pad, border, pad);
+    }
+
+};
@@ -4,7 +4,11 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/mman.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -14,7 +18,17 @@
 #include <cassert>
 #include <functional>
 #include <iomanip>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "alloc.h"
 #include "log.h"
+#include "profile.h"
+#include "parse.h"
+#include "perf.h"
+#include "point.h"
+#include "scan.h"
 
 #ifndef NDEBUG
 #define DEBUG(x) do { \
@@ -25,7 +39,7 @@
 #endif
 
 #define DEBUG_PRINT(x) do { DEBUG(std::cout << __func__ << ":" << __LINE__ << ": " << x << std::endl); } while (0)
-#define DEBUG_LOG(...) do { DEBUG(LOG(__func__, __VA_ARGS__)); } while (0)
+#define DEBUG_LOG(...) LOG_AT(AOC_LOG_DEBUG, __func__, __VA_ARGS__)
 
 #define STRING_CONSTANT(symbol, value) constexpr std::string_view symbol(value)
 
@@ -38,47 +52,10 @@
 #endif
 
 namespace aoc {
+    using Point = Vec2;
 
-    using Point = std::pair<int, int>;
-
-}
-
-aoc::Point operator+(const aoc::Point& lhs, const aoc::Point& rhs) {
-    aoc::Point out{lhs.first + rhs.first, lhs.second + rhs.second};
-    return out;
-}
-
-aoc::Point operator*(const aoc::Point& lhs, const int x) {
-    aoc::Point out{lhs.first * x, lhs.second * x};
-    return out;
-}
-
-aoc::Point& operator+=(aoc::Point& lhs, const aoc::Point& rhs) {
-    lhs.first += rhs.first;
-    lhs.second += rhs.second;
-    return lhs;
-}
-
-aoc::Point& operator*=(aoc::Point& lhs, const int x) {
-    lhs.first *= x;
-    lhs.second *= x;
-    return lhs;
-}
-
-aoc::Point operator-(const aoc::Point& lhs, const aoc::Point& rhs) {
-    aoc::Point out{lhs.first - rhs.first, lhs.second - rhs.second};
-    return out;
-}
-namespace aoc { 
-   // Needed if we want to store a point in a hash
-    struct PointHash {
-        std::size_t operator() (const aoc::Point& pair) const {
-            size_t v = pair.first;
-            v <<= 32;
-            v |= pair.second;
-            return v;
-        }
-    };
+    // Kept for existing containers, std::hash<Point> is the same thing
+    using PointHash = VecHash;
 
     template <typename T> int sgn(T val) {
         return (T(0) < val) - (val < T(0));
@@ -91,7 +68,7 @@ namespace aoc {
         West = 270,
     };
 
-    CardinalDirection fromBearing(int32_t bearing) {
+    constexpr CardinalDirection fromBearing(int32_t bearing) {
         while (bearing < 0) {
             bearing += 360;
         }
@@ -112,19 +89,19 @@ namespace aoc {
         }
     }
 
-    CardinalDirection turnLeft(CardinalDirection dir) {
+    constexpr CardinalDirection turnLeft(CardinalDirection dir) {
         int32_t bearing = static_cast<int32_t>(dir);
         bearing -= 90;
         return fromBearing(bearing);
     }
 
-    CardinalDirection turnRight(CardinalDirection dir) {
+    constexpr CardinalDirection turnRight(CardinalDirection dir) {
         int32_t bearing = static_cast<int32_t>(dir);
         bearing += 90;
         return fromBearing(bearing);
     }
 
-    aoc::Point stepFromCardinalDirection(CardinalDirection dir) {
+    constexpr aoc::Point stepFromCardinalDirection(CardinalDirection dir) {
         switch (dir) {
             case CardinalDirection::North:
                 return { 0, 1 };
@@ -138,13 +115,24 @@ namespace aoc {
         throw std::runtime_error("Bad direction: " + std::to_string(static_cast<int32_t>(dir)));
     }
 
-    aoc::Point moveInDirection(const aoc::Point pt, CardinalDirection dir, int steps) {
-      aoc::Point step = stepFromCardinalDirection(dir) * steps;
+    constexpr aoc::Point moveInDirection(const aoc::Point pt, CardinalDirection dir, int steps) {
+      const aoc::Point step = stepFromCardinalDirection(dir) * steps;
       return pt + step;
     }
 
+    // Results are printed here rather than to std::cout directly, so a runner
+    // executing several days at once can capture each day's output separately
+    inline std::ostream*& out_stream() {
+        thread_local std::ostream* os = &std::cout;
+        return os;
+    }
+
+    inline std::ostream& out() {
+        return *out_stream();
+    }
+
     const auto print_result = [](int part, auto result) {
-        std::cout << "Part " << part << ": " << result << std::endl;
+        out() << "Part " << part << ": " << result << std::endl;
     };
 
     const auto print_results = [](const auto& part1, const auto& part2) {
@@ -153,15 +141,15 @@ namespace aoc {
     };
 
     const auto assert_result = [](auto r, auto e) {
-        std::cout << "Expected: " << e << " Got: " << r;
+        out() << "Expected: " << e << " Got: " << r;
         if (e != r) {
-            std::cout << " FAILED" << std::endl;
+            out() << " FAILED" << std::endl;
             exit(-1);
         }
-        std::cout << " OK" << std::endl;
+        out() << " OK" << std::endl;
     };
 
-    auto open_argv_1(int argc, char **argv) {
+    inline auto open_argv_1(int argc, char **argv) {
         if (argc < 2) {
             throw std::runtime_error("Insufficient arguments");
         }
@@ -171,31 +159,31 @@ namespace aoc {
         return f;
     }
 
-    std::ostream& bold_on(std::ostream& os) {
+    inline std::ostream& bold_on(std::ostream& os) {
         return os << "\e[1m";
     }
 
-    std::ostream& bold_off(std::ostream& os) {
+    inline std::ostream& bold_off(std::ostream& os) {
         return os << "\e[0m";
     }
 
-    std::ostream& cls(std::ostream& os) {
+    inline std::ostream& cls(std::ostream& os) {
         return os << "\033[2J\033[1;1H";
     }
 
-    bool ends_with(const std::string_view s, const std::string_view p) {
+    inline bool ends_with(const std::string_view s, const std::string_view p) {
         if (s.size() < p.size()) { return false; }
         const auto e = s.substr(s.size() - p.size());
         return e == p;
     }
 
-    bool starts_with(const std::string_view s, const std::string_view p) {
+    inline bool starts_with(const std::string_view s, const std::string_view p) {
         if (s.size() < p.size()) { return false; }
         const auto e = s.substr(0, p.size());
         return e == p;
     }
 
-    bool is_numeric(const char c) {
+    constexpr bool is_numeric(const char c) {
         switch (c) {
             case '0':
             case '1':
@@ -213,7 +201,7 @@ namespace aoc {
         }
     }
 
-    bool is_numeric(const std::string_view sv) {
+    constexpr bool is_numeric(const std::string_view sv) {
         if (sv.empty()) { return false; }
         bool first = true;
         for (const auto& c : sv) {
@@ -226,49 +214,25 @@ namespace aoc {
         return true;
     }
 
-    int64_t stoi(std::string_view sv) {
-        bool neg = false;
-        bool first = true;
-        int64_t out = 0;
-        for (const auto& c : sv) {
-            switch (c) {
-                case '0':
-                    out *= 10; break;
-                case '1':
-                    out *= 10; out += 1; break;
-                case '2':
-                    out *= 10; out += 2; break;
-                case '3':
-                    out *= 10; out += 3; break;
-                case '4':
-                    out *= 10; out += 4; break;
-                case '5':
-                    out *= 10; out += 5; break;
-                case '6':
-                    out *= 10; out += 6; break;
-                case '7':
-                    out *= 10; out += 7; break;
-                case '8':
-                    out *= 10; out += 8; break;
-                case '9':
-                    out *= 10; out += 9; break;
-                case '-':
-                    if (first) { neg = true; break; }
-                    [[fallthrough]];
-                default:
-                    throw std::runtime_error("Not an integer: `" + std::string(sv) + "'");
-            }
-            first = false;
+    // Throwing wrapper over parse_int, for input that has to be an integer
+    template <typename Int = int64_t>
+    constexpr Int stoi(std::string_view sv) {
+        Int out = 0;
+        const auto status = parse_int(sv, out);
+        if (status != ParseStatus::Ok) {
+            throw std::runtime_error("Not an integer (" + std::string(to_string(status)) + "): `" + std::string(sv) + "'");
         }
-        return out * (1 - 2 * neg);
+        return out;
     }
 
-    bool getline(std::string_view& s, std::string_view& out, const std::string_view delims, bool return_empty = false) {
+    // Splits the next token off s at any byte in delims, skipping empty tokens
+    // unless return_empty is set
+    constexpr bool getline(std::string_view& s, std::string_view& out, const DelimiterSet& delims, bool return_empty = false) {
         out = std::string_view();
         if (s.empty()) { return false; }
 
         do {
-            const size_t end = s.find_first_of(delims);
+            const size_t end = find_first_of(s, delims);
 
             if (end != std::string_view::npos) {
                 out = s.substr(0, end);
@@ -283,104 +247,312 @@ namespace aoc {
         return (return_empty || !out.empty());
     }
 
-    bool getline(std::string_view& s, std::string_view& out, const char delim) {
-        return getline(s, out, std::string_view(&delim, 1));
+    constexpr bool getline(std::string_view& s, std::string_view& out, const std::string_view delims, bool return_empty = false) {
+        return getline(s, out, DelimiterSet(delims), return_empty);
+    }
+    constexpr bool getline(std::string_view& s, std::string_view& out, const char delim) {
+        return getline(s, out, DelimiterSet(std::string_view(&delim, 1)));
+    }
+    // Delimiters known at compile time, e.g. getline<',', ' '>(s, out). An
+    // empty list would make getline(s, out, ",") pick this, via const char* to bool
+    template <char... Delims, typename = std::enable_if_t<(sizeof...(Delims) > 0)>>
+    constexpr bool getline(std::string_view& s, std::string_view& out, bool return_empty = false) {
+        return getline(s, out, delimiters<Delims...>, return_empty);
+    }
+    constexpr bool getline(std::string_view& s, std::string_view& out) {
+        return getline<'\r', '\n'>(s, out);
+    }
+
+    // Reads straight from the stream buffer rather than through get(), which
+    // builds a sentry per character
+    inline bool getline(std::istream& s, std::string& out, const DelimiterSet& delims) {
+        out.clear();
+        std::streambuf* sb = s.rdbuf();
+        if (!sb || !s.good()) { return false; }
+        for (int c = sb->sgetc(); ; c = sb->snextc()) {
+            if (c == std::char_traits<char>::eof()) {
+                s.setstate(std::ios::eofbit);
+                return !out.empty();
+            }
+            if (delims.contains(static_cast<char>(c))) {
+                if (out.empty()) { continue; }
+                sb->sbumpc();
+                return true;
+            }
+            out.push_back(static_cast<char>(c));
+        }
+    }
+    inline bool getline(std::istream& s, std::string& out, const std::string_view delims) {
+        return getline(s, out, DelimiterSet(delims));
     }
-    bool getline(std::string_view& s, std::string_view& out) {
-        return getline(s, out, std::string_view("\r\n", 2));
+    // std::getline scans the stream buffer with memchr for a single delimiter
+    inline bool getline(std::istream& s, std::string& out, const char delim) {
+        while (std::getline(s, out, delim)) {
+            if (!out.empty()) { return true; }
+        }
+        out.clear();
+        return false;
     }
+    inline bool getline(std::istream& s, std::string& out) {
+        return getline(s, out, delimiters<'\r', '\n'>);
+    }
+
+    // Streams a file in large blocks with read(2). Lines are handed out as
+    // views into the block buffer that stay valid until the next read; only a
+    // line straddling two blocks is moved to the front of the buffer to be
+    // completed. Memory stays at two blocks plus the longest line, so pipes and
+    // sockets are consumed at close to mmap speed without holding the input.
+    class BlockReader {
+    public:
+        static constexpr size_t DefaultBlockSize = 1 << 20;
+
+        explicit BlockReader(int fd, size_t block_size = DefaultBlockSize, bool owns_fd = false)
+            : _fd(fd)
+            , _owns_fd(owns_fd)
+            , _block(simd::round_up(std::max<size_t>(block_size, 1), PageSize))
+            , _buffer(2 * _block)
+        {}
+
+        // "-" reads stdin
+        explicit BlockReader(const char *filename, size_t block_size = DefaultBlockSize)
+            : BlockReader(open_file(filename), block_size, std::string_view(filename) != "-")
+        {}
+
+        BlockReader(BlockReader&& other) noexcept
+            : _fd(std::exchange(other._fd, -1))
+            , _owns_fd(std::exchange(other._owns_fd, false))
+            , _block(other._block)
+            , _buffer(std::move(other._buffer))
+            , _pos(std::exchange(other._pos, 0))
+            , _end(std::exchange(other._end, 0))
+            , _eof(std::exchange(other._eof, true))
+            , _wait(std::move(other._wait))
+            , _period(other._period)
+            , _follow(other._follow)
+        {}
+
+        BlockReader(const BlockReader&) = delete;
+        BlockReader& operator=(const BlockReader&) = delete;
+        BlockReader& operator=(BlockReader&&) = delete;
+
+        ~BlockReader() {
+            if (_owns_fd && _fd >= 0) {
+                ::close(_fd);
+            }
+        }
+
+        // Calls wait each time the reader goes back to the fd for input and
+        // about every period while none arrives, so callers can do timed work
+        // however slowly input trickles in. With follow, the end of a regular
+        // file means no input yet and reading goes on as it grows, like
+        // tail -f; on anything else end of input is still the end.
+        void on_wait(std::chrono::milliseconds period, std::function<void()> wait, bool follow = false) {
+            struct stat st;
+            _wait = std::move(wait);
+            _period = period;
+            _follow = follow && ::fstat(_fd, &st) == 0 && S_ISREG(st.st_mode);
+        }
 
-    bool getline(std::istream& s, std::string& out, const std::string_view delims) {
-        char c;
-        out.resize(0);
-        while (s.good() && (c = s.get())) {
-            if (delims.find(c) != std::string_view::npos) {
-                if (out.empty()) {
+        // Same contract as getline over a string_view
+        bool getline(std::string_view& out, const DelimiterSet& delims, bool return_empty = false) {
+            size_t scanned = 0;
+            for (;;) {
+                const std::string_view rest(_buffer.data() + _pos + scanned, _end - _pos - scanned);
+                const size_t at = find_first_of(rest, delims);
+                if (at != std::string_view::npos) {
+                    out = std::string_view(_buffer.data() + _pos, scanned + at);
+                    _pos += scanned + at + 1;
+                    if (return_empty || !out.empty()) { return true; }
+                    scanned = 0;
                     continue;
                 }
-                return true;
+                if (_eof) {
+                    out = std::string_view(_buffer.data() + _pos, _end - _pos);
+                    _pos = _end;
+                    return !out.empty();
+                }
+                scanned = _end - _pos;
+                fill();
+            }
+        }
+
+    private:
+        static constexpr size_t PageSize = 4096;
+
+        static int open_file(const char *filename) {
+            if (!filename) { throw std::runtime_error("BlockReader: nullptr"); }
+            if (std::string_view(filename) == "-") { return STDIN_FILENO; }
+            const int fd = ::open(filename, O_RDONLY);
+            if (fd == -1) { throw std::runtime_error("BlockReader: open failed: " + std::string(filename)); }
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            return fd;
+        }
+
+        // Moves the unread tail to the front and reads one more block after
+        // it, growing the buffer only when the tail is longer than a block
+        void fill() {
+            const size_t tail = _end - _pos;
+            if (_pos > 0) {
+                std::memmove(_buffer.data(), _buffer.data() + _pos, tail);
+                _pos = 0;
+                _end = tail;
             }
-            if (c > 0) {
-                out.append(&c, 1);
+            if (_buffer.size() - _end < _block) {
+                _buffer.resize(simd::round_up(_end + _block, _block));
+            }
+            for (;;) {
+                if (_wait) { _wait(); }
+                if (_wait && !_follow && !readable()) {
+                    continue;
+                }
+                const ssize_t r = ::read(_fd, _buffer.data() + _end, _buffer.size() - _end);
+                if (r < 0) {
+                    if (errno == EINTR) { continue; }
+                    throw std::runtime_error("BlockReader: read failed");
+                }
+                if (r == 0 && _follow) {
+                    std::this_thread::sleep_for(_period);
+                    continue;
+                }
+                _eof = r == 0;
+                _end += r;
+                return;
             }
         }
-        return !out.empty() || s.good();
-    }
-    bool getline(std::istream& s, std::string& out, const char delim) {
-        return getline(s, out, std::string_view(&delim, 1));
-    }
-    bool getline(std::istream& s, std::string& out) {
-        char c;
-        out.resize(0);
-        while (s.good() && (c = s.get())) {
-            switch (c) {
-                case '\r':
-                case '\n':
-                    if (out.empty()) { continue; }
-                    return true;
-                default:
-                    if (c > 0) {
-                        out.append(&c, 1);
-                    }
-                    break;
+
+        // False when nothing arrived within the wait period
+        bool readable() const {
+            pollfd p{ _fd, POLLIN, 0 };
+            const int n = ::poll(&p, 1, static_cast<int>(_period.count()));
+            if (n < 0 && errno != EINTR) {
+                throw std::runtime_error("BlockReader: poll failed");
             }
+            return n > 0;
+        }
+
+        int _fd;
+        bool _owns_fd;
+        size_t _block;
+        std::vector<char, simd::AlignedAllocator<char, PageSize>> _buffer;
+        size_t _pos = 0;
+        size_t _end = 0;
+        bool _eof = false;
+        std::function<void()> _wait;
+        std::chrono::milliseconds _period{100};
+        bool _follow = false;
+    };
+
+    inline bool getline(BlockReader& r, std::string_view& out, const std::string_view delims, bool return_empty = false) {
+        return r.getline(out, DelimiterSet(delims), return_empty);
+    }
+    inline bool getline(BlockReader& r, std::string_view& out, const char delim) {
+        return r.getline(out, DelimiterSet(std::string_view(&delim, 1)));
+    }
+    inline bool getline(BlockReader& r, std::string_view& out) {
+        return r.getline(out, delimiters<'\r', '\n'>);
+    }
+
+    inline BlockReader open_block_reader(int argc, char **argv) {
+        if (argc < 2) {
+            throw std::runtime_error("Insufficient arguments");
         }
-        return !out.empty() || s.good();
+        return BlockReader(argv[1]);
     }
 
-    using UnaryIntFunction = std::function<void(const int64_t)>;
-    void parse_as_integers(std::istream& s, const char delim, UnaryIntFunction op) {
+    // Calls op with every token that parses as an Int, other tokens are skipped
+    template <typename Int = int64_t, typename F>
+    void parse_as_integers(std::istream& s, const char delim, F&& op) {
         std::string l;
         while (getline(s, l, delim)) {
-            try {
-                const auto n = stoi(l);
+            Int n;
+            if (parse_int(l, n) == ParseStatus::Ok) {
                 op(n);
-            } catch (...) { }
+            }
         }
     }
-    void parse_as_integers(std::istream& s, const std::string_view delims, UnaryIntFunction op) {
+    template <typename Int = int64_t, typename F>
+    void parse_as_integers(std::istream& s, const std::string_view delims, F&& op) {
         std::string l;
         while (getline(s, l, delims)) {
-            try {
-                const auto n = stoi(l);
+            Int n;
+            if (parse_int(l, n) == ParseStatus::Ok) {
                 op(n);
-            } catch (...) { }
+            }
         }
     }
-    void parse_as_integers(std::istream& s, UnaryIntFunction op) {
+    template <typename Int = int64_t, typename F>
+    void parse_as_integers(std::istream& s, F&& op) {
         std::string l;
         while (getline(s, l)) {
-            try {
-                const auto n = stoi(l);
+            Int n;
+            if (parse_int(l, n) == ParseStatus::Ok) {
+                op(n);
+            }
+        }
+    }
+    template <typename Int = int64_t, typename F>
+    void parse_as_integers(BlockReader& r, const char delim, F&& op) {
+        std::string_view l;
+        while (getline(r, l, delim)) {
+            Int n;
+            if (parse_int(l, n) == ParseStatus::Ok) {
+                op(n);
+            }
+        }
+    }
+    template <typename Int = int64_t, typename F>
+    void parse_as_integers(BlockReader& r, const std::string_view delims, F&& op) {
+        std::string_view l;
+        while (getline(r, l, delims)) {
+            Int n;
+            if (parse_int(l, n) == ParseStatus::Ok) {
+                op(n);
+            }
+        }
+    }
+    template <typename Int = int64_t, typename F>
+    void parse_as_integers(BlockReader& r, F&& op) {
+        std::string_view l;
+        while (getline(r, l)) {
+            Int n;
+            if (parse_int(l, n) == ParseStatus::Ok) {
                 op(n);
-            } catch (...) { }
+            }
         }
     }
-    void parse_as_integers(const std::string& s, const char delim, UnaryIntFunction op) {
+    template <typename Int = int64_t, typename F>
+    void parse_as_integers(const std::string& s, const char delim, F&& op) {
         std::string_view ss(s);
         std::string_view l;
         while (getline(ss, l, delim)) {
-            try {
-                const auto n = stoi(l);
+            Int n;
+            if (parse_int(l, n) == ParseStatus::Ok) {
                 op(n);
-            } catch (...) { }
+            }
         }
     }
-    void parse_as_integers(const std::string_view s, const std::string_view delims, UnaryIntFunction op) {
+    template <typename Int = int64_t, typename F>
+    void parse_as_integers(const std::string_view s, const std::string_view delims, F&& op) {
         std::string_view ss(s);
         std::string_view l;
         while (getline(ss, l, delims)) {
-            try {
-                const auto n = stoi(l);
+            Int n;
+            if (parse_int(l, n) == ParseStatus::Ok) {
                 op(n);
-            } catch (...) { }
+            }
         }
     }
 
+    // Prints wall time for its scope, hardware counters as well when AOC_PERF
+    // is set and the counters can be opened (see perf.h), and heap traffic
+    // when built with AOC_ALLOC_STATS (see alloc.h)
     class AutoTimer {
     private:
         std::chrono::time_point<std::chrono::high_resolution_clock> start_;
         std::string name_;
+        PerfCounters counters_;
+        AllocScope allocs_;
+        size_t bytes_ = 0;
 
     public:
         AutoTimer()
@@ -402,63 +574,127 @@ namespace aoc {
 
         void reset() {
             start_ = std::chrono::high_resolution_clock::now();
+            counters_.reset();
+            allocs_.reset();
+        }
+
+        // Size of the input the scope works through, counter misses are
+        // reported per byte of it
+        void set_bytes(size_t bytes) {
+            bytes_ = bytes;
         }
 
     private:
-        // Needs to be a lambda due to use of auto
         void calculate_time () const {
             const auto end = std::chrono::high_resolution_clock::now();
+            const auto counts = counters_.read();
+            const auto allocs = allocs_.read();
 
             // Calculating total time taken by the program.
             double time_taken = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_).count();
             time_taken *= 1e-9;
 
-            std::cout << "Elapsed" << (name_.empty() ? "" : " " + name_) << ": " << std::fixed << time_taken << std::setprecision(9) << " sec" << std::endl;
+            // Formatted on the side so out() keeps its own flags
+            std::ostringstream os;
+            os << "Elapsed" << (name_.empty() ? "" : " " + name_) << ": " << std::fixed << std::setprecision(6) << time_taken << " sec" << std::endl;
+            print_perf_sample(os, counts, bytes_);
+            if (alloc_stats_enabled) {
+                print_alloc_stats(os, allocs);
+            }
+            out() << os.str();
         }
 
     };
 
+    // madvise/mmap hints for MappedFileSource, combine with |
+    enum class AccessHint : uint32_t {
+        Normal = 0,
+        // Aggressive read-ahead, pages behind the reader may be dropped early
+        Sequential = 1 << 0,
+        // Start reading the whole file in now
+        WillNeed = 1 << 1,
+        // Fault every page in up front with MAP_POPULATE
+        Populate = 1 << 2,
+        // Ask for transparent huge pages where the kernel supports them
+        HugePages = 1 << 3,
+    };
+
+    constexpr AccessHint operator|(AccessHint lhs, AccessHint rhs) {
+        return static_cast<AccessHint>(static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+    }
+
+    constexpr bool operator&(AccessHint lhs, AccessHint rhs) {
+        return (static_cast<uint32_t>(lhs) & static_cast<uint32_t>(rhs)) != 0;
+    }
+
+    // Read-only view of a whole input. Regular files are mapped; pipes, sockets,
+    // stdin (given as "-") and files that report a zero size are read into an
+    // anonymous mapping that doubles as it fills, so both cases expose one buffer.
     template<typename T>
     class MappedFileSource {
     public:
 
         MappedFileSource()
-            : _fd(0)
-            , _size(0)
+            : _size(0)
+            , _capacity(0)
             , _map(nullptr)
+            , _hints(AccessHint::Sequential)
         {}
 
-        MappedFileSource(const char *filename) 
+        MappedFileSource(const char *filename, AccessHint hints = AccessHint::Sequential)
             : MappedFileSource()
         {
+            _hints = hints;
             map_file(filename);
         }
 
-        MappedFileSource(int argc, char **argv)
+        MappedFileSource(int argc, char **argv, AccessHint hints = AccessHint::Sequential)
             : MappedFileSource()
         {
             if (argc < 2) {
                 throw std::runtime_error("Insufficient arguments");
             }
 
+            _hints = hints;
             map_file(argv[1]);
         }
 
+        MappedFileSource(MappedFileSource&& other) noexcept
+            : MappedFileSource()
+        {
+            swap(other);
+        }
+
+        MappedFileSource& operator=(MappedFileSource&& other) noexcept {
+            if (this != &other) {
+                reset();
+                swap(other);
+            }
+            return *this;
+        }
+
+        MappedFileSource(const MappedFileSource&) = delete;
+        MappedFileSource& operator=(const MappedFileSource&) = delete;
+
         ~MappedFileSource() {
             reset();
         }
 
+        void swap(MappedFileSource& other) noexcept {
+            std::swap(_size, other._size);
+            std::swap(_capacity, other._capacity);
+            std::swap(_map, other._map);
+            std::swap(_hints, other._hints);
+        }
+
         void reset() {
             if (_map) {
-                ::munmap(_map, _size);
-            }
-            if (_fd) {
-                ::close(_fd);
+                ::munmap(_map, _capacity);
             }
 
             _map = nullptr;
-            _fd = 0;
             _size = 0;
+            _capacity = 0;
         }
 
         void reset(const char *filename) {
@@ -468,18 +704,34 @@ namespace aoc {
 
         void map_file(const char *filename) {
             if (!filename) { throw std::runtime_error("map_file: nullptr"); }
-            if (_fd || _map || _size) { throw std::runtime_error("map_file: already mapped"); }
+            if (_map || _size) { throw std::runtime_error("map_file: already mapped"); }
+
+            if (std::string_view(filename) == "-") {
+                read_stream(STDIN_FILENO);
+                return;
+            }
 
-            _fd = ::open(filename, O_RDONLY);
-            if (_fd == -1) { throw std::runtime_error("map_file: open failed"); }
+            const int fd = ::open(filename, O_RDONLY);
+            if (fd == -1) { throw std::runtime_error("map_file: open failed: " + std::string(filename)); }
 
             struct stat fs;
-            int r = ::fstat(_fd, &fs);
-            if (r == -1) { reset(); throw std::runtime_error("map_file: fstat failed"); }
-            _size = fs.st_size;
+            if (::fstat(fd, &fs) == -1) {
+                ::close(fd);
+                throw std::runtime_error("map_file: fstat failed");
+            }
 
-            _map = (T*)::mmap(0, _size, PROT_READ, MAP_SHARED, _fd, 0);
-            if (!_map) { reset(); throw std::runtime_error("map_file: mmap failed"); }
+            try {
+                if (S_ISREG(fs.st_mode) && fs.st_size > 0) {
+                    map_regular(fd, fs.st_size);
+                } else {
+                    read_stream(fd);
+                }
+            } catch (...) {
+                ::close(fd);
+                throw;
+            }
+            // The mapping keeps its own reference to the file
+            ::close(fd);
         }
 
         const T* data() const { return _map; }
@@ -487,8 +739,106 @@ namespace aoc {
 
     private:
 
-        int _fd;
+        void map_regular(int fd, size_t size) {
+            int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            if (_hints & AccessHint::Populate) { flags |= MAP_POPULATE; }
+#endif
+            void* map = ::mmap(nullptr, size, PROT_READ, flags, fd, 0);
+            if (map == MAP_FAILED) { throw std::runtime_error("map_file: mmap failed"); }
+
+            _map = static_cast<T*>(map);
+            _size = size;
+            _capacity = size;
+            advise(true);
+        }
+
+        void read_stream(int fd) {
+            size_t capacity = 1 << 20;
+            void* buf = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (buf == MAP_FAILED) { throw std::runtime_error("map_file: buffer allocation failed"); }
+            _map = static_cast<T*>(buf);
+            _capacity = capacity;
+            advise(false);
+
+            for (;;) {
+                if (_size == _capacity) {
+                    grow();
+                }
+
+                const ssize_t r = ::read(fd, reinterpret_cast<char*>(_map) + _size, _capacity - _size);
+                if (r == 0) { break; }
+                if (r < 0) {
+                    if (errno == EINTR) { continue; }
+                    reset();
+                    throw std::runtime_error("map_file: read failed");
+                }
+                _size += r;
+            }
+            ::mprotect(_map, _capacity, PROT_READ);
+        }
+
+        // Doubles the stream buffer, which mremap can do without copying
+        void grow() {
+            const size_t capacity = _capacity * 2;
+#ifdef MREMAP_MAYMOVE
+            void* grown = ::mremap(_map, _capacity, capacity, MREMAP_MAYMOVE);
+            if (grown == MAP_FAILED) { reset(); throw std::runtime_error("map_file: buffer growth failed"); }
+#else
+            void* grown = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (grown == MAP_FAILED) { reset(); throw std::runtime_error("map_file: buffer growth failed"); }
+            std::memcpy(grown, _map, _size * sizeof(T));
+            ::munmap(_map, _capacity);
+#endif
+            _map = static_cast<T*>(grown);
+            _capacity = capacity;
+            advise(false);
+        }
+
+        // Hints are best effort, the kernel is free to ignore them. Read-ahead
+        // hints only mean something for pages backed by a file.
+        void advise(bool file) {
+            if (file && (_hints & AccessHint::Sequential)) { ::madvise(_map, _capacity, MADV_SEQUENTIAL); }
+            if (file && (_hints & AccessHint::WillNeed)) { ::madvise(_map, _capacity, MADV_WILLNEED); }
+#ifdef MADV_HUGEPAGE
+            if (_hints & AccessHint::HugePages) { ::madvise(_map, _capacity, MADV_HUGEPAGE); }
+#endif
+        }
+
         size_t _size;
+        size_t _capacity;
         T* _map;
+        AccessHint _hints;
+    };
+
+    // Entry point of a day built into the runner, see AOC_MAIN
+    using DayMain = int (*)(int argc, char** argv);
+
+    struct DayEntry {
+        const char* name;
+        DayMain main;
+    };
+
+    inline std::vector<DayEntry>& day_registry() {
+        static std::vector<DayEntry> days;
+        return days;
+    }
+
+    struct RegisterDay {
+        RegisterDay(const char* name, DayMain main) {
+            day_registry().push_back({ name, main });
+        }
     };
 };
+
+// Declares a day's entry point. Standalone builds get a plain main, while the
+// runner compiles every day into one binary with AOC_RUNNER and AOC_DAY_NAME
+// defined, so each day registers itself under its name instead.
+#if defined(AOC_RUNNER)
+#define AOC_MAIN(...) \
+    static int aoc_day_main(__VA_ARGS__); \
+    static const ::aoc::RegisterDay aoc_day_registration(STRINGIZE(AOC_DAY_NAME), aoc_day_main); \
+    static int aoc_day_main(__VA_ARGS__)
+#else
+#define AOC_MAIN(...) int main(__VA_ARGS__)
+#endif
@@ -1,8 +1,21 @@
 #pragma once
 
-#include <sys/time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #define STRINGIZE(arg) STRINGIZE1(arg)
 #define STRINGIZE1(arg) STRINGIZE2(arg)
@@ -43,18 +56,383 @@
 #define FOR_EACH_(N, what, ...) CONCATENATE(FOR_EACH_, N)(what, __VA_ARGS__)
 #define FOR_EACH(what, ...) FOR_EACH_(FOR_EACH_NARG(__VA_ARGS__), what, __VA_ARGS__)
 
-#define LN_TRACE_ARG_TO_OSTR(x) ostr << STRINGIZE(x) << "=" << x << " ";
+// Asynchronous logger. A LOG call only copies a timestamp, a pointer to its
+// static call site and the raw bytes of its arguments into a per-thread ring
+// buffer; a background thread decodes and prints them. When a ring is full the
+// message is dropped and counted rather than blocking the caller.
 
+#define AOC_LOG_TRACE 0
+#define AOC_LOG_DEBUG 1
+#define AOC_LOG_INFO 2
+#define AOC_LOG_WARN 3
+#define AOC_LOG_ERROR 4
+#define AOC_LOG_OFF 5
 
-#define LOG(tp, ...) do {                                                                                \
-                                                                                                                \
-    struct timeval tv;                                                                                           \
-    gettimeofday(&tv, NULL);                                                                                     \
-    struct tm lt;                                                                                                \
-    localtime_r(&tv.tv_sec, &lt);                                                                                \
-    std::ostringstream ostr;                                                                                     \
-    ostr << tp << " : ";                                                                              \
-    FOR_EACH(LN_TRACE_ARG_TO_OSTR, __VA_ARGS__);                                                                 \
-    fprintf(stderr, "%02d/%02d/%02d %02d:%02d:%02d.%06ld %s\n", lt.tm_mon + 1, lt.tm_mday, lt.tm_year % 100,      \
-            lt.tm_hour, lt.tm_min, lt.tm_sec, tv.tv_usec, ostr.str().c_str());                                   \
+// Messages below this level are compiled out
+#ifndef AOC_LOG_LEVEL
+#ifdef NDEBUG
+#define AOC_LOG_LEVEL AOC_LOG_INFO
+#else
+#define AOC_LOG_LEVEL AOC_LOG_DEBUG
+#endif
+#endif
+
+namespace aoc::log {
+
+    // One per LOG statement, its address doubles as the format id
+    struct Site {
+        const char* tp;
+        // The argument expressions as written, comma separated
+        const char* names;
+    };
+
+    using Decoder = void (*)(std::ostream&, const char* names, const uint8_t* payload);
+
+    struct Header {
+        uint32_t size;
+        uint64_t ts_ns;
+        const Site* site;
+        Decoder decode;
+    };
+
+    template <typename T>
+    using Decayed = std::remove_cv_t<std::remove_reference_t<T>>;
+
+    template <typename T>
+    constexpr bool is_string_like = std::is_convertible_v<const T&, std::string_view>;
+
+    // Strings are stored as a length followed by the bytes, everything else raw
+    template <typename T>
+    size_t encoded_size(const T& v) {
+        if constexpr (is_string_like<T>) {
+            return sizeof(uint32_t) + std::string_view(v).size();
+        } else {
+            static_assert(std::is_trivially_copyable_v<T>, "LOG arguments must be strings or trivially copyable");
+            return sizeof(T);
+        }
+    }
+
+    template <typename T>
+    const uint8_t* decode_one(std::ostream& os, const uint8_t* p) {
+        if constexpr (is_string_like<T>) {
+            uint32_t n;
+            std::memcpy(&n, p, sizeof(n));
+            os.write(reinterpret_cast<const char*>(p + sizeof(n)), n);
+            return p + sizeof(n) + n;
+        } else {
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            if constexpr (std::is_enum_v<T>) {
+                os << static_cast<std::underlying_type_t<T>>(v);
+            } else {
+                os << v;
+            }
+            return p + sizeof(T);
+        }
+    }
+
+    // Splits the stringized argument list at top level commas
+    inline std::vector<std::string_view> split_names(std::string_view names) {
+        std::vector<std::string_view> out;
+        int depth = 0;
+        char quote = 0;
+        size_t start = 0;
+        for (size_t i = 0; i < names.size(); i++) {
+            const char c = names[i];
+            if (quote) {
+                if (c == '\\') { i++; }
+                else if (c == quote) { quote = 0; }
+                continue;
+            }
+            switch (c) {
+                case '"': case '\'': quote = c; break;
+                case '(': case '[': case '{': depth++; break;
+                case ')': case ']': case '}': depth--; break;
+                case ',':
+                    if (depth == 0) {
+                        out.push_back(names.substr(start, i - start));
+                        start = i + 1;
+                    }
+                    break;
+            }
+        }
+        out.push_back(names.substr(start));
+        for (auto& n : out) {
+            while (!n.empty() && n.front() == ' ') { n.remove_prefix(1); }
+            while (!n.empty() && n.back() == ' ') { n.remove_suffix(1); }
+        }
+        return out;
+    }
+
+    template <typename... Args>
+    void decode(std::ostream& os, const char* names, const uint8_t* p) {
+        const auto n = split_names(names);
+        size_t i = 0;
+        ((os << (i < n.size() ? n[i] : std::string_view("?")) << "=", p = decode_one<Args>(os, p), os << " ", i++), ...);
+    }
+
+    // Single producer, single consumer byte ring
+    class Ring {
+    public:
+        static constexpr size_t Capacity = 1 << 20;
+
+        Ring()
+            : data_(new uint8_t[Capacity])
+        {}
+
+        // Producer side: reserve n bytes, returns the write cursor or ~0 when full
+        uint64_t reserve(size_t n) {
+            const uint64_t h = head_.load(std::memory_order_relaxed);
+            if (h + n - cached_tail_ > Capacity) {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if (h + n - cached_tail_ > Capacity) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return ~uint64_t(0);
+                }
+            }
+            return h;
+        }
+
+        void put(uint64_t& at, const void* src, size_t n) {
+            const size_t off = at % Capacity;
+            const size_t first = std::min(n, Capacity - off);
+            std::memcpy(data_.get() + off, src, first);
+            std::memcpy(data_.get(), static_cast<const uint8_t*>(src) + first, n - first);
+            at += n;
+        }
+
+        void commit(uint64_t at) {
+            head_.store(at, std::memory_order_release);
+        }
+
+        // Called by the producer as its thread exits, after its last commit
+        void close() {
+            closed_.store(true, std::memory_order_release);
+        }
+
+        bool closed() const {
+            return closed_.load(std::memory_order_acquire);
+        }
+
+        // Consumer side: nothing published is left undrained
+        bool empty() const {
+            return tail_.load(std::memory_order_relaxed) == head_.load(std::memory_order_acquire);
+        }
+
+        // Consumer side: decodes everything published so far
+        size_t drain(std::ostream& os, std::vector<uint8_t>& scratch) {
+            uint64_t t = tail_.load(std::memory_order_relaxed);
+            const uint64_t h = head_.load(std::memory_order_acquire);
+            size_t count = 0;
+            while (t < h) {
+                Header hdr;
+                get(t, &hdr, sizeof(hdr));
+                scratch.resize(hdr.size - sizeof(hdr));
+                get(t + sizeof(hdr), scratch.data(), scratch.size());
+                t += hdr.size;
+
+                const time_t secs = hdr.ts_ns / 1000000000;
+                struct tm lt;
+                localtime_r(&secs, &lt);
+                char stamp[64];
+                snprintf(stamp, sizeof(stamp), "%02d/%02d/%02d %02d:%02d:%02d.%06lu ", lt.tm_mon + 1, lt.tm_mday, lt.tm_year % 100,
+                    lt.tm_hour, lt.tm_min, lt.tm_sec, static_cast<unsigned long>(hdr.ts_ns % 1000000000 / 1000));
+                os << stamp << hdr.site->tp << " : ";
+                hdr.decode(os, hdr.site->names, scratch.data());
+                os << '\n';
+                count++;
+            }
+            tail_.store(t, std::memory_order_release);
+
+            const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+            if (dropped) {
+                os << "log: dropped " << dropped << " messages\n";
+            }
+            return count;
+        }
+
+    private:
+        void get(uint64_t at, void* dst, size_t n) const {
+            const size_t off = at % Capacity;
+            const size_t first = std::min(n, Capacity - off);
+            std::memcpy(dst, data_.get() + off, first);
+            std::memcpy(static_cast<uint8_t*>(dst) + first, data_.get(), n - first);
+        }
+
+        std::unique_ptr<uint8_t[]> data_;
+        alignas(64) std::atomic<uint64_t> head_{0};
+        uint64_t cached_tail_ = 0;
+        alignas(64) std::atomic<uint64_t> tail_{0};
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<bool> closed_{false};
+    };
+
+    class Logger {
+    public:
+        static Logger& instance() {
+            static Logger logger;
+            return logger;
+        }
+
+        ~Logger() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            if (worker_.joinable()) {
+                worker_.join();
+            }
+            drain();
+        }
+
+        // Rings are shared with the logger so messages from threads that have
+        // already exited are still printed. A thread closes its ring as it
+        // exits and the logger lets go of it on the next drain after that, so
+        // short lived pool threads do not each leave a ring behind.
+        // Called by a producer after it commits to its ring
+        void published() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping_.load(std::memory_order_relaxed)) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    sleeping_.store(false, std::memory_order_relaxed);
+                }
+                cv_.notify_one();
+            }
+        }
+
+        Ring& thread_ring() {
+            thread_local RingHandle handle{ [this]() {
+                auto r = std::make_shared<Ring>();
+                std::lock_guard<std::mutex> lock(mutex_);
+                rings_.push_back(r);
+                if (!worker_.joinable()) {
+                    worker_ = std::thread([this]() { run(); });
+                }
+                return r;
+            }() };
+            return *handle.ring;
+        }
+
+    private:
+        struct RingHandle {
+            std::shared_ptr<Ring> ring;
+
+            ~RingHandle() {
+                ring->close();
+            }
+        };
+
+        Logger() = default;
+
+        // The worker sleeps until a producer publishes into a ring, so an
+        // idle logger costs nothing. It raises sleeping_ and then looks at
+        // the rings once more; a producer commits and then looks at
+        // sleeping_. With a fence on each side at least one of them sees the
+        // other's store, so a message is never left waiting for a wakeup.
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stop_) {
+                lock.unlock();
+                const size_t n = drain();
+                lock.lock();
+                if (n) { continue; }
+                sleeping_.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                const bool idle = std::all_of(rings_.begin(), rings_.end(), [](const std::shared_ptr<Ring>& r) {
+                    return r->empty();
+                });
+                if (idle) {
+                    cv_.wait(lock, [this]() { return stop_ || !sleeping_.load(std::memory_order_relaxed); });
+                }
+                sleeping_.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        size_t drain() {
+            std::vector<std::shared_ptr<Ring>> rings;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                rings = rings_;
+            }
+            size_t n = 0;
+            size_t finished = 0;
+            for (const auto& r : rings) {
+                // Closed before the drain, so the drain sees its last message
+                const bool closed = r->closed();
+                n += r->drain(out_, scratch_);
+                finished += closed;
+            }
+            if (n) {
+                const auto s = out_.str();
+                std::fwrite(s.data(), 1, s.size(), stderr);
+                out_.str(std::string());
+            }
+            if (finished) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<Ring>& r) {
+                    return r->closed() && r->empty();
+                }), rings_.end());
+            }
+            return n;
+        }
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<std::shared_ptr<Ring>> rings_;
+        std::thread worker_;
+        bool stop_ = false;
+        std::atomic<bool> sleeping_{false};
+        std::ostringstream out_;
+        std::vector<uint8_t> scratch_;
+    };
+
+    template <typename T>
+    void put_arg(Ring& ring, uint64_t& at, const T& v) {
+        if constexpr (is_string_like<T>) {
+            const std::string_view s(v);
+            const uint32_t n = s.size();
+            ring.put(at, &n, sizeof(n));
+            ring.put(at, s.data(), n);
+        } else {
+            ring.put(at, &v, sizeof(T));
+        }
+    }
+
+    template <typename... Args>
+    void write(const Site& site, const Args&... args) {
+        const size_t size = sizeof(Header) + (size_t(0) + ... + encoded_size(args));
+        if (size > Ring::Capacity) { return; }
+
+        Logger& logger = Logger::instance();
+        Ring& ring = logger.thread_ring();
+        uint64_t at = ring.reserve(size);
+        if (at == ~uint64_t(0)) { return; }
+
+        const Header hdr{
+            static_cast<uint32_t>(size),
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count()),
+            &site,
+            &decode<Decayed<Args>...>,
+        };
+        ring.put(at, &hdr, sizeof(hdr));
+        (put_arg(ring, at, args), ...);
+        ring.commit(at);
+        logger.published();
+    }
+
+};
+
+#define LOG_ARG_NAMES(...) #__VA_ARGS__
+
+// tp must outlive the process, e.g. __func__ or a string literal
+#define LOG_AT(level, tp, ...) do {                                                  \
+    if constexpr ((level) >= AOC_LOG_LEVEL) {                                        \
+        static const ::aoc::log::Site aoc_log_site{ tp, LOG_ARG_NAMES(__VA_ARGS__) }; \
+        ::aoc::log::write(aoc_log_site, __VA_ARGS__);                                \
+    }                                                                                \
 } while (0)
+
+#define LOG(tp, ...) LOG_AT(AOC_LOG_INFO, tp, __VA_ARGS__)
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace aoc {
+
+    // Worker count for default_pool(), $AOC_THREADS when set, otherwise one
+    // per hardware thread
+    inline size_t default_thread_count() {
+        if (const char* env = std::getenv("AOC_THREADS")) {
+            char* end = nullptr;
+            const long n = std::strtol(env, &end, 10);
+            if (!*env || *end || n < 1) {
+                throw std::runtime_error("Bad AOC_THREADS: " + std::string(env));
+            }
+            return static_cast<size_t>(n);
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Work-stealing pool. Every worker owns a deque: work spawned on a worker
+    // goes onto the back of its own deque and is popped from the back, so a
+    // worker keeps descending into the task it just split, while idle workers
+    // steal from the front of other deques, where the largest pieces are.
+    // Work from outside the pool is dealt round robin across the deques.
+    class ThreadPool {
+    public:
+        explicit ThreadPool(size_t threads = default_thread_count()) {
+            threads = std::max<size_t>(1, threads);
+            queues_.reserve(threads);
+            for (size_t i = 0; i < threads; i++) {
+                queues_.push_back(std::make_unique<Queue>());
+            }
+            workers_.reserve(threads);
+            for (size_t i = 0; i < threads; i++) {
+                workers_.emplace_back([this, i]() { run(i); });
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            for (auto& w : workers_) {
+                w.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        size_t size() const { return workers_.size(); }
+
+        // Queues job without any way to wait for it, see TaskGroup
+        void push(std::function<void()> job) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                pending_++;
+            }
+            const auto& self = worker();
+            const size_t q = self.pool == this ? self.index : next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+            {
+                std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+                queues_[q]->jobs.push_back(std::move(job));
+            }
+            cv_.notify_one();
+        }
+
+        template <typename F>
+        auto submit(F f) -> std::future<decltype(f())> {
+            using R = decltype(f());
+            auto task = std::make_shared<std::packaged_task<R()>>(std::move(f));
+            auto result = task->get_future();
+            push([task]() { (*task)(); });
+            return result;
+        }
+
+        // Runs one queued job on the calling thread, returns false if there
+        // was nothing to run. Used by threads waiting on a TaskGroup.
+        bool run_one() {
+            std::function<void()> job;
+            if (!take(job)) { return false; }
+            job();
+            return true;
+        }
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> jobs;
+        };
+
+        struct Worker {
+            ThreadPool* pool = nullptr;
+            size_t index = 0;
+        };
+
+        static Worker& worker() {
+            thread_local Worker w;
+            return w;
+        }
+
+        bool take(std::function<void()>& job) {
+            const auto& self = worker();
+            const bool own = self.pool == this;
+            if (own) {
+                auto& q = *queues_[self.index];
+                std::lock_guard<std::mutex> lock(q.mutex);
+                if (!q.jobs.empty()) {
+                    job = std::move(q.jobs.back());
+                    q.jobs.pop_back();
+                    pending_--;
+                    return true;
+                }
+            }
+
+            const size_t n = queues_.size();
+            const size_t first = own ? self.index + 1 : next_.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < n; i++) {
+                auto& q = *queues_[(first + i) % n];
+                std::lock_guard<std::mutex> lock(q.mutex);
+                if (!q.jobs.empty()) {
+                    job = std::move(q.jobs.front());
+                    q.jobs.pop_front();
+                    pending_--;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void run(size_t index) {
+            worker() = { this, index };
+            for (;;) {
+                if (run_one()) { continue; }
+                std::unique_lock<std::mutex> lock(mutex_);
+                // A job is counted before it is queued, so pending_ can briefly
+                // be ahead of what take() finds; that only costs a retry
+                cv_.wait(lock, [this]() { return stop_ || pending_ > 0; });
+                if (stop_ && pending_ == 0) { return; }
+            }
+        }
+
+        std::vector<std::unique_ptr<Queue>> queues_;
+        std::vector<std::thread> workers_;
+        std::atomic<size_t> next_{ 0 };
+        // Jobs queued and not yet taken, only raised under mutex_ so sleeping
+        // workers cannot miss one
+        std::atomic<int64_t> pending_{ 0 };
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        bool stop_ = false;
+    };
+
+    inline ThreadPool& default_pool() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // Fork/join scope: spawn() queues work on the pool and sync() waits for all
+    // of it. A thread waiting in sync() runs queued work rather than blocking,
+    // so groups nest freely inside tasks without starving the pool. The first
+    // exception thrown by a task is rethrown from sync().
+    class TaskGroup {
+    public:
+        explicit TaskGroup(ThreadPool& pool = default_pool())
+            : pool_(pool)
+        {}
+
+        ~TaskGroup() {
+            wait();
+        }
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        template <typename F>
+        void spawn(F f) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                pending_++;
+            }
+            pool_.push([this, f = std::move(f)]() mutable {
+                std::exception_ptr error;
+                try {
+                    f();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                // Last touch of the group, sync() cannot return until it is released
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (error && !error_) { error_ = error; }
+                if (--pending_ == 0) { cv_.notify_all(); }
+            });
+            // Counted once queued, so a waiter woken by it can find the task
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                spawned_++;
+            }
+            cv_.notify_all();
+        }
+
+        void sync() {
+            wait();
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (error_) {
+                std::rethrow_exception(std::exchange(error_, nullptr));
+            }
+        }
+
+    private:
+        void wait() {
+            for (;;) {
+                size_t seen = 0;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (pending_ == 0) { return; }
+                    seen = spawned_;
+                }
+                if (pool_.run_one()) { continue; }
+                // Everything left is running elsewhere: sleep until it is done
+                // or splits off more work to help with
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this, seen]() { return pending_ == 0 || spawned_ != seen; });
+            }
+        }
+
+        ThreadPool& pool_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        size_t pending_ = 0;
+        // Tasks queued so far, wakes a waiter when new work may be stealable
+        size_t spawned_ = 0;
+        std::exception_ptr error_;
+    };
+
+    namespace detail {
+        // Halves [lo, hi) until pieces are at most grain long, spawning the
+        // upper halves and running the last piece in place
+        template <typename F>
+        void split_range(TaskGroup& g, size_t lo, size_t hi, size_t grain, const F& fn) {
+            while (hi - lo > grain) {
+                const size_t mid = lo + (hi - lo) / 2;
+                g.spawn([&g, mid, hi, grain, &fn]() { split_range(g, mid, hi, grain, fn); });
+                hi = mid;
+            }
+            if (lo < hi) {
+                fn(lo, hi);
+            }
+        }
+
+        // Pieces small enough to balance, large enough to amortise a task
+        inline size_t auto_grain(size_t n, const ThreadPool& pool) {
+            return std::max<size_t>(1, n / (pool.size() * 8));
+        }
+    }
+
+    // Calls fn(i) for every i in [begin, end), in grain sized pieces, 0 picks
+    // a grain from the range and pool size
+    template <typename F>
+    void parallel_for(size_t begin, size_t end, F fn, size_t grain = 0, ThreadPool& pool = default_pool()) {
+        if (begin >= end) { return; }
+        grain = grain ? grain : detail::auto_grain(end - begin, pool);
+        // Spawned pieces refer to body, so it has to outlive the sync
+        const auto body = [&fn](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                fn(i);
+            }
+        };
+        TaskGroup g(pool);
+        detail::split_range(g, begin, end, grain, body);
+        g.sync();
+    }
+
+    // Folds reduce(lo, hi) over grain sized pieces of [begin, end) into init
+    // with combine. Pieces are combined in index order, so combine only has to
+    // be associative.
+    template <typename Result, typename Reduce, typename Combine>
+    Result parallel_reduce(size_t begin, size_t end, Result init, Reduce reduce, Combine combine, size_t grain = 0, ThreadPool& pool = default_pool()) {
+        if (begin >= end) { return init; }
+        grain = grain ? grain : detail::auto_grain(end - begin, pool);
+        const size_t pieces = (end - begin + grain - 1) / grain;
+        if (pieces == 1) {
+            return combine(std::move(init), reduce(begin, end));
+        }
+
+        std::vector<std::optional<Result>> partials(pieces);
+        parallel_for(0, pieces, [&](size_t i) {
+            const size_t lo = begin + i * grain;
+            partials[i].emplace(reduce(lo, std::min(end, lo + grain)));
+        }, 1, pool);
+        for (auto& p : partials) {
+            init = combine(std::move(init), std::move(*p));
+        }
+        return init;
+    }
+
+    struct SplitOptions {
+        // Records end with this byte
+        char delimiter = '\n';
+        // Chunks hold whole groups of this many records, counted from the start
+        size_t group = 1;
+        // Number of chunks, 0 picks one per pool thread
+        size_t chunks = 0;
+        // Inputs are not split below this many bytes per chunk
+        size_t min_chunk_bytes = 1 << 20;
+    };
+
+    namespace detail {
+        // Blank records are skipped by lines() and getline, so they never count
+        // towards a group: empty, or only the '\r' of a CRLF line ending
+        inline bool blank_record(std::string_view r) {
+            return r.find_first_not_of('\r') == std::string_view::npos;
+        }
+
+        // Non-blank records in sv, which ends just after a delimiter
+        inline size_t count_records(std::string_view sv, char delimiter) {
+            size_t n = 0;
+            for (size_t at = 0; at < sv.size();) {
+                const size_t end = sv.find(delimiter, at);
+                const size_t next = end == std::string_view::npos ? sv.size() : end;
+                n += !blank_record(sv.substr(at, next - at));
+                at = next + 1;
+            }
+            return n;
+        }
+    }
+
+    // Cuts sv into at most opts.chunks pieces that each start on a record group
+    // boundary. Group boundaries need the global record index, so the records in
+    // each rough chunk are counted in parallel first and the cut points are then
+    // moved forward to the next group. Blank records are not counted.
+    inline std::vector<std::string_view> split_records(std::string_view sv, const SplitOptions& opts, ThreadPool& pool = default_pool()) {
+        const size_t want = opts.chunks ? opts.chunks : pool.size();
+        const size_t n = std::max<size_t>(1, std::min(want, sv.size() / std::max<size_t>(1, opts.min_chunk_bytes)));
+        if (n == 1) {
+            return { sv };
+        }
+
+        // Cut just after a delimiter near each even split point
+        std::vector<size_t> cuts{ 0 };
+        for (size_t i = 1; i < n; i++) {
+            const size_t at = sv.find(opts.delimiter, std::max(cuts.back(), sv.size() / n * i));
+            if (at == std::string_view::npos) { break; }
+            cuts.push_back(at + 1);
+        }
+        cuts.push_back(sv.size());
+
+        if (opts.group > 1) {
+            std::vector<size_t> counts(cuts.size() - 2);
+            parallel_for(0, counts.size(), [&](size_t i) {
+                const auto chunk = sv.substr(cuts[i], cuts[i + 1] - cuts[i]);
+                counts[i] = detail::count_records(chunk, opts.delimiter);
+            }, 1, pool);
+
+            size_t records = 0;
+            for (size_t i = 1; i + 1 < cuts.size(); i++) {
+                records += counts[i - 1];
+                for (size_t skip = (opts.group - records % opts.group) % opts.group; skip > 0 && cuts[i] < sv.size();) {
+                    const size_t at = sv.find(opts.delimiter, cuts[i]);
+                    const size_t end = at == std::string_view::npos ? sv.size() : at;
+                    skip -= !detail::blank_record(sv.substr(cuts[i], end - cuts[i]));
+                    cuts[i] = at == std::string_view::npos ? sv.size() : at + 1;
+                }
+            }
+            for (size_t i = 1; i < cuts.size(); i++) {
+                cuts[i] = std::max(cuts[i], cuts[i - 1]);
+            }
+        }
+
+        std::vector<std::string_view> out;
+        for (size_t i = 0; i + 1 < cuts.size(); i++) {
+            if (cuts[i + 1] > cuts[i]) {
+                out.push_back(sv.substr(cuts[i], cuts[i + 1] - cuts[i]));
+            }
+        }
+        return out;
+    }
+
+    // Applies fn to every item on the pool, results come back in input order.
+    // A single item runs on the calling thread.
+    template <typename T, typename F>
+    auto parallel_map(const std::vector<T>& items, F fn, ThreadPool& pool = default_pool()) {
+        using R = decltype(fn(items.front()));
+        std::vector<std::optional<R>> results(items.size());
+        parallel_for(0, items.size(), [&](size_t i) { results[i].emplace(fn(items[i])); }, 1, pool);
+
+        std::vector<R> out;
+        out.reserve(items.size());
+        for (auto& r : results) {
+            out.push_back(std::move(*r));
+        }
+        return out;
+    }
+
+    // Calls fn on each chunk of sv, see split_records
+    template <typename F>
+    void parallel_for(std::string_view sv, const SplitOptions& opts, F fn, ThreadPool& pool = default_pool()) {
+        const auto chunks = split_records(sv, opts, pool);
+        parallel_for(0, chunks.size(), [&](size_t i) { fn(chunks[i]); }, 1, pool);
+    }
+
+    // Runs reduce over each chunk of sv and folds the partial results, in input
+    // order, into init with combine
+    template <typename Result, typename Reduce, typename Combine>
+    Result parallel_reduce(std::string_view sv, const SplitOptions& opts, Result init, Reduce reduce, Combine combine, ThreadPool& pool = default_pool()) {
+        const auto chunks = split_records(sv, opts, pool);
+        return parallel_reduce(0, chunks.size(), std::move(init), [&](size_t lo, size_t) {
+            return reduce(chunks[lo]);
+        }, combine, 1, pool);
+    }
+
+};
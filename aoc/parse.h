@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "simd.h"
+
+namespace aoc {
+
+    enum class ParseStatus {
+        Ok = 0,
+        InvalidCharacter,
+        Overflow,
+    };
+
+    constexpr const char* to_string(ParseStatus status) {
+        switch (status) {
+            case ParseStatus::Ok:
+                return "ok";
+            case ParseStatus::InvalidCharacter:
+                return "invalid character";
+            case ParseStatus::Overflow:
+                return "overflow";
+        }
+        return "unknown";
+    }
+
+    struct ParseResult {
+        ParseStatus status;
+        // Offset of the offending token, or the input size on success
+        size_t offset;
+
+        constexpr explicit operator bool() const { return status == ParseStatus::Ok; }
+    };
+
+    constexpr bool is_space(const char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    struct FromCharsResult {
+        // One past the last digit consumed, or first if there were none
+        const char* ptr;
+        ParseStatus status;
+    };
+
+    // Parses the integer at the start of [first, last) like std::from_chars:
+    // an optional '-' for signed types then as many digits as follow. Works
+    // for any integer width and reports overflow rather than wrapping.
+    template <typename Int>
+    constexpr FromCharsResult from_chars(const char* first, const char* last, Int& out) {
+        static_assert(std::is_integral_v<Int> && !std::is_same_v<Int, bool>, "from_chars needs an integer type");
+        const char* p = first;
+        bool neg = false;
+        if constexpr (std::is_signed_v<Int>) {
+            if (p != last && *p == '-') {
+                neg = true;
+                p++;
+            }
+        }
+
+        // Signed values accumulate negatively so the minimum round trips
+        const char* digits = p;
+        Int v = 0;
+        bool overflow = false;
+        for (; p != last; p++) {
+            const unsigned d = static_cast<unsigned char>(*p) - '0';
+            if (d > 9) { break; }
+            if constexpr (std::is_signed_v<Int>) {
+                overflow = overflow || __builtin_mul_overflow(v, 10, &v) || __builtin_sub_overflow(v, static_cast<Int>(d), &v);
+            } else {
+                overflow = overflow || __builtin_mul_overflow(v, 10u, &v) || __builtin_add_overflow(v, static_cast<Int>(d), &v);
+            }
+        }
+        if (p == digits) { return { first, ParseStatus::InvalidCharacter }; }
+        if constexpr (std::is_signed_v<Int>) {
+            if (!neg) {
+                overflow = overflow || v == std::numeric_limits<Int>::min();
+                v = static_cast<Int>(-v);
+            }
+        }
+        if (overflow) { return { p, ParseStatus::Overflow }; }
+        out = v;
+        return { p, ParseStatus::Ok };
+    }
+
+    // Converts a whole token of the form -?[0-9]+ without throwing. A bad
+    // character takes precedence over overflow.
+    template <typename Int>
+    constexpr ParseStatus parse_int(const char* p, size_t n, Int& out) {
+        Int v = 0;
+        const auto r = from_chars(p, p + n, v);
+        if (r.ptr != p + n || (r.status == ParseStatus::InvalidCharacter)) { return ParseStatus::InvalidCharacter; }
+        if (r.status == ParseStatus::Ok) { out = v; }
+        return r.status;
+    }
+
+    template <typename Int>
+    constexpr ParseStatus parse_int(std::string_view sv, Int& out) {
+        return parse_int(sv.data(), sv.size(), out);
+    }
+
+    constexpr ParseStatus parse_token(const char* p, size_t n, int64_t& out) {
+        return parse_int(p, n, out);
+    }
+
+    namespace detail {
+
+        // Converts up to 8 ASCII digits in one go, p must have 8 readable bytes
+        inline uint64_t parse_eight_digits(const char* p, size_t n) {
+            uint64_t chunk;
+            std::memcpy(&chunk, p, sizeof(chunk));
+            chunk &= 0x0F0F0F0F0F0F0F0FULL;
+            // Shift the digits to the top so the missing leading digits read as zero
+            chunk <<= 8 * (8 - n);
+            chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFULL;
+            chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFULL;
+            chunk = (chunk * 10000 + (chunk >> 32)) & 0x00000000FFFFFFFFULL;
+            return chunk;
+        }
+
+        // Scalar tokenizer, stops at the first bad token
+        inline ParseResult parse_integers_scalar(std::string_view sv, size_t pos, std::vector<int64_t>& out) {
+            const char* p = sv.data();
+            const size_t n = sv.size();
+            while (pos < n) {
+                while (pos < n && is_space(p[pos])) { pos++; }
+                if (pos == n) { break; }
+
+                const size_t start = pos;
+                while (pos < n && !is_space(p[pos])) { pos++; }
+
+                int64_t v;
+                const auto status = parse_token(p + start, pos - start, v);
+                if (status != ParseStatus::Ok) {
+                    return { status, start };
+                }
+                out.push_back(v);
+            }
+            return { ParseStatus::Ok, n };
+        }
+
+    };
+
+    // Parses a buffer of whitespace separated integers into out in a single pass.
+    // Bytes are classified 64 at a time with SIMD, short tokens are converted with
+    // SWAR and anything unusual drops to the scalar tokenizer. Values are appended
+    // to out; on failure out holds every value before the offending token.
+    inline ParseResult parse_integers(std::string_view sv, std::vector<int64_t>& out) {
+        size_t pos = 0;
+#if defined(AOC_HAVE_AVX2) || defined(AOC_HAVE_SSE42)
+        const char* p = sv.data();
+        const size_t n = sv.size();
+        while (pos + simd::BlockSize <= n) {
+            const auto m = simd::classify_block(p + pos);
+            if (~(m.digit | m.space | m.minus)) {
+                // The scalar path reports the exact failing token
+                return detail::parse_integers_scalar(sv, pos, out);
+            }
+
+            uint64_t tokens = ~m.space;
+            if (!tokens) {
+                pos += simd::BlockSize;
+                continue;
+            }
+
+            // Blocks always begin on a token boundary, so bit 0 can start a run
+            uint64_t starts = tokens & ~(tokens << 1);
+            const uint64_t ends = tokens & ~(tokens >> 1);
+            // A run touching the last byte may continue into the next block
+            const bool open = tokens >> 63;
+            size_t next = pos + simd::BlockSize;
+            if (open) {
+                const size_t last = 63 - __builtin_clzll(starts);
+                if (last == 0) {
+                    // One token covers the whole block, no point in vectorizing it
+                    size_t end = pos + simd::BlockSize;
+                    while (end < n && !is_space(p[end])) { end++; }
+                    int64_t v;
+                    const auto status = parse_token(p + pos, end - pos, v);
+                    if (status != ParseStatus::Ok) {
+                        return { status, pos };
+                    }
+                    out.push_back(v);
+                    pos = end;
+                    continue;
+                }
+                starts &= simd::low_bits(last);
+                next = pos + last;
+            }
+
+            uint64_t e = ends;
+            while (starts) {
+                const size_t s = simd::ctz(starts);
+                const size_t f = simd::ctz(e);
+                starts = simd::clear_lowest(starts);
+                e = simd::clear_lowest(e);
+
+                const char* t = p + pos + s;
+                const size_t len = f - s + 1;
+                const bool neg = (m.minus >> s) & 1;
+                const uint64_t body = simd::low_bits(f + 1) & ~simd::low_bits(s + 1);
+                if ((m.minus & body) || (neg && len == 1)) {
+                    return { ParseStatus::InvalidCharacter, pos + s };
+                }
+
+                const size_t digits = len - neg;
+                if (digits <= 8 && t + neg + 8 <= p + n) {
+                    const auto v = static_cast<int64_t>(detail::parse_eight_digits(t + neg, digits));
+                    out.push_back(neg ? -v : v);
+                } else {
+                    int64_t v;
+                    const auto status = parse_token(t, len, v);
+                    if (status != ParseStatus::Ok) {
+                        return { status, pos + s };
+                    }
+                    out.push_back(v);
+                }
+            }
+            pos = next;
+        }
+#endif
+        return detail::parse_integers_scalar(sv, pos, out);
+    }
+
+};
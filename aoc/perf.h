@@ -0,0 +1,195 @@
+#pragma once
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string_view>
+#include <utility>
+
+// Hardware counters for a scoped region, read through perf_event_open(2).
+//
+// Counter mode is off unless AOC_PERF is set to a non-zero value in the
+// environment. Counters follow the thread that opened them and any threads it
+// starts afterwards, which covers a day's pool as it is created lazily on first
+// use. Threads that already existed are not counted.
+//
+// Opening can fail for many reasons (no PMU in a VM or container,
+// perf_event_paranoid, seccomp); counters that cannot be opened are left out,
+// and without the cycle counter there is nothing to report, so callers fall
+// back to wall time without any noise. Other platforms have no counters at all.
+
+namespace aoc {
+
+    enum class PerfCounter {
+        Cycles,
+        Instructions,
+        L1DMisses,
+        LLCMisses,
+        BranchMisses,
+        Count,
+    };
+
+    inline bool perf_counters_enabled() {
+        static const bool enabled = []() {
+            const char* env = std::getenv("AOC_PERF");
+            return env && *env && std::string_view(env) != "0";
+        }();
+        return enabled;
+    }
+
+    struct PerfSample {
+        std::array<uint64_t, static_cast<size_t>(PerfCounter::Count)> value{};
+        std::array<bool, static_cast<size_t>(PerfCounter::Count)> valid{};
+        // Lowest fraction of the region any counter was actually scheduled,
+        // below 1 when the PMU was multiplexed and values are extrapolated.
+        // Only reported under 99%, inherited counters rarely reach exactly 1
+        double coverage = 1;
+
+        bool has(PerfCounter c) const { return valid[static_cast<size_t>(c)]; }
+        uint64_t operator[](PerfCounter c) const { return value[static_cast<size_t>(c)]; }
+    };
+
+#if defined(__linux__)
+    class PerfCounters {
+    public:
+        static constexpr size_t Count = static_cast<size_t>(PerfCounter::Count);
+
+        PerfCounters() {
+            fds_.fill(-1);
+            if (!perf_counters_enabled()) { return; }
+
+            constexpr uint64_t ReadMiss = PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+            const std::array<std::pair<uint32_t, uint64_t>, Count> events = {{
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+                { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | ReadMiss },
+                { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | ReadMiss },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            }};
+            for (size_t i = 0; i < Count; i++) {
+                fds_[i] = open(events[i].first, events[i].second, fds_[0]);
+                // Everything else is grouped under the cycle counter
+                if (fds_[0] < 0) { return; }
+            }
+            start_ = read_all();
+        }
+
+        ~PerfCounters() {
+            for (const int fd : fds_) {
+                if (fd >= 0) { ::close(fd); }
+            }
+        }
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        bool available() const { return fds_[0] >= 0; }
+
+        void reset() {
+            if (available()) { start_ = read_all(); }
+        }
+
+        // Counts since construction or the last reset()
+        PerfSample read() const {
+            PerfSample out;
+            if (!available()) { return out; }
+            const auto now = read_all();
+            for (size_t i = 0; i < Count; i++) {
+                if (!now[i].ok) { continue; }
+                const uint64_t value = now[i].value - start_[i].value;
+                const uint64_t enabled = now[i].enabled - start_[i].enabled;
+                const uint64_t running = now[i].running - start_[i].running;
+                if (running == 0) { continue; }
+                const double scale = static_cast<double>(enabled) / running;
+                out.value[i] = static_cast<uint64_t>(value * scale);
+                out.valid[i] = true;
+                out.coverage = std::min(out.coverage, 1 / scale);
+            }
+            return out;
+        }
+
+    private:
+        struct Reading {
+            uint64_t value = 0;
+            uint64_t enabled = 0;
+            uint64_t running = 0;
+            bool ok = false;
+        };
+
+        static int open(uint32_t type, uint64_t config, int group) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC));
+        }
+
+        std::array<Reading, Count> read_all() const {
+            std::array<Reading, Count> out{};
+            for (size_t i = 0; i < Count; i++) {
+                uint64_t buf[3];
+                if (fds_[i] >= 0 && ::read(fds_[i], buf, sizeof(buf)) == static_cast<ssize_t>(sizeof(buf))) {
+                    out[i] = { buf[0], buf[1], buf[2], true };
+                }
+            }
+            return out;
+        }
+
+        std::array<int, Count> fds_;
+        std::array<Reading, Count> start_{};
+    };
+#else
+    class PerfCounters {
+    public:
+        bool available() const { return false; }
+        void reset() {}
+        PerfSample read() const { return {}; }
+    };
+#endif
+
+    // One line summary: IPC tells frontend or dependency bound code from code
+    // waiting on memory, misses per input byte tell which level it waits on
+    inline void print_perf_sample(std::ostream& os, const PerfSample& s, size_t bytes) {
+        if (!s.has(PerfCounter::Cycles)) { return; }
+
+        const auto flags = os.flags();
+        const auto precision = os.precision();
+        os << "Counters: " << s[PerfCounter::Cycles] << " cycles";
+        if (s.has(PerfCounter::Instructions) && s[PerfCounter::Cycles]) {
+            os << std::fixed << std::setprecision(2) << ", IPC " << static_cast<double>(s[PerfCounter::Instructions]) / s[PerfCounter::Cycles];
+        }
+        const std::pair<PerfCounter, const char*> misses[] = {
+            { PerfCounter::L1DMisses, "L1D misses" },
+            { PerfCounter::LLCMisses, "LLC misses" },
+            { PerfCounter::BranchMisses, "branch misses" },
+        };
+        for (const auto& [c, name] : misses) {
+            if (!s.has(c)) { continue; }
+            os << ", " << name << " " << s[c];
+            if (bytes) {
+                os << std::fixed << std::setprecision(4) << " (" << static_cast<double>(s[c]) / bytes << "/B)";
+            }
+        }
+        if (s.coverage < 0.99) {
+            os << std::fixed << std::setprecision(0) << " [scaled, " << s.coverage * 100 << "% counted]";
+        }
+        os << std::endl;
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+};
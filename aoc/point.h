@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+
+namespace aoc {
+
+    // Finaliser from splitmix64. Every input bit reaches every output bit, so
+    // keys that differ only in their high word, or only in sign, still spread
+    // over all buckets.
+    constexpr uint64_t hash_mix(uint64_t v) {
+        v ^= v >> 30;
+        v *= 0xbf58476d1ce4e5b9ull;
+        v ^= v >> 27;
+        v *= 0x94d049bb133111ebull;
+        v ^= v >> 31;
+        return v;
+    }
+
+    constexpr int64_t abs64(int64_t v) {
+        return v < 0 ? -v : v;
+    }
+
+    // 2D integer vector packed into 8 bytes. Plain int32_t members and no
+    // branches, so arrays of them vectorise, and a whole value moves in one
+    // 64-bit register.
+    struct alignas(8) Vec2 {
+        int32_t x = 0;
+        int32_t y = 0;
+
+        // x in the high word, y in the low word, each as two's complement
+        constexpr uint64_t pack() const {
+            return uint64_t(uint32_t(x)) << 32 | uint32_t(y);
+        }
+
+        static constexpr Vec2 unpack(uint64_t v) {
+            return { int32_t(uint32_t(v >> 32)), int32_t(uint32_t(v)) };
+        }
+
+        constexpr Vec2& operator+=(const Vec2& o) { x += o.x; y += o.y; return *this; }
+        constexpr Vec2& operator-=(const Vec2& o) { x -= o.x; y -= o.y; return *this; }
+        constexpr Vec2& operator*=(int32_t k) { x *= k; y *= k; return *this; }
+
+        constexpr Vec2 operator+(const Vec2& o) const { return { x + o.x, y + o.y }; }
+        constexpr Vec2 operator-(const Vec2& o) const { return { x - o.x, y - o.y }; }
+        constexpr Vec2 operator-() const { return { -x, -y }; }
+        constexpr Vec2 operator*(int32_t k) const { return { x * k, y * k }; }
+
+        constexpr bool operator==(const Vec2& o) const { return pack() == o.pack(); }
+        constexpr bool operator!=(const Vec2& o) const { return pack() != o.pack(); }
+        // Lexicographic, x then y
+        constexpr bool operator<(const Vec2& o) const { return x < o.x || (x == o.x && y < o.y); }
+    };
+
+    // 3D integer vector. Packs into 64 bits as three 21-bit fields, so only
+    // components in [-2^20, 2^20) survive a round trip through pack().
+    struct Vec3 {
+        static constexpr int PackBits = 21;
+        static constexpr int32_t PackMin = -(1 << (PackBits - 1));
+        static constexpr int32_t PackMax = (1 << (PackBits - 1)) - 1;
+
+        int32_t x = 0;
+        int32_t y = 0;
+        int32_t z = 0;
+
+        constexpr uint64_t pack() const {
+            constexpr uint64_t mask = (uint64_t(1) << PackBits) - 1;
+            return (uint64_t(uint32_t(x)) & mask) << (2 * PackBits) | (uint64_t(uint32_t(y)) & mask) << PackBits | (uint64_t(uint32_t(z)) & mask);
+        }
+
+        static constexpr Vec3 unpack(uint64_t v) {
+            // Shift each field to the top and back down to sign extend it
+            const auto field = [](uint64_t f) {
+                return int32_t(int64_t(f << (64 - PackBits)) >> (64 - PackBits));
+            };
+            return { field(v >> (2 * PackBits)), field(v >> PackBits), field(v) };
+        }
+
+        constexpr Vec3& operator+=(const Vec3& o) { x += o.x; y += o.y; z += o.z; return *this; }
+        constexpr Vec3& operator-=(const Vec3& o) { x -= o.x; y -= o.y; z -= o.z; return *this; }
+        constexpr Vec3& operator*=(int32_t k) { x *= k; y *= k; z *= k; return *this; }
+
+        constexpr Vec3 operator+(const Vec3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+        constexpr Vec3 operator-(const Vec3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+        constexpr Vec3 operator-() const { return { -x, -y, -z }; }
+        constexpr Vec3 operator*(int32_t k) const { return { x * k, y * k, z * k }; }
+
+        constexpr bool operator==(const Vec3& o) const { return x == o.x && y == o.y && z == o.z; }
+        constexpr bool operator!=(const Vec3& o) const { return !(*this == o); }
+        constexpr bool operator<(const Vec3& o) const {
+            return x < o.x || (x == o.x && (y < o.y || (y == o.y && z < o.z)));
+        }
+    };
+
+    // Distances are widened to 64 bits, the difference of two int32_t
+    // components does not fit in one
+    constexpr int64_t manhattan(const Vec2& a, const Vec2& b = {}) {
+        return abs64(int64_t(a.x) - b.x) + abs64(int64_t(a.y) - b.y);
+    }
+
+    constexpr int64_t manhattan(const Vec3& a, const Vec3& b = {}) {
+        return abs64(int64_t(a.x) - b.x) + abs64(int64_t(a.y) - b.y) + abs64(int64_t(a.z) - b.z);
+    }
+
+    constexpr int64_t chebyshev(const Vec2& a, const Vec2& b = {}) {
+        const int64_t dx = abs64(int64_t(a.x) - b.x);
+        const int64_t dy = abs64(int64_t(a.y) - b.y);
+        return dx > dy ? dx : dy;
+    }
+
+    constexpr int64_t chebyshev(const Vec3& a, const Vec3& b = {}) {
+        const int64_t d = chebyshev(Vec2{ a.x, a.y }, Vec2{ b.x, b.y });
+        const int64_t dz = abs64(int64_t(a.z) - b.z);
+        return d > dz ? d : dz;
+    }
+
+    // Component wise bounds, e.g. for the bounding box of a set of points
+    constexpr Vec2 min(const Vec2& a, const Vec2& b) {
+        return { a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y };
+    }
+
+    constexpr Vec2 max(const Vec2& a, const Vec2& b) {
+        return { a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y };
+    }
+
+    // Hash for unordered containers, also what std::hash uses below. Vec3 is
+    // mixed from all three components rather than pack(), which would alias
+    // points outside the 21-bit range.
+    struct VecHash {
+        size_t operator()(const Vec2& v) const {
+            return hash_mix(v.pack());
+        }
+
+        size_t operator()(const Vec3& v) const {
+            return hash_mix(Vec2{ v.x, v.y }.pack() ^ hash_mix(uint32_t(v.z)));
+        }
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const Vec2& v) {
+        return os << "(" << v.x << ", " << v.y << ")";
+    }
+
+    inline std::ostream& operator<<(std::ostream& os, const Vec3& v) {
+        return os << "(" << v.x << ", " << v.y << ", " << v.z << ")";
+    }
+
+};
+
+namespace std {
+    template <>
+    struct hash<aoc::Vec2> {
+        size_t operator()(const aoc::Vec2& v) const { return aoc::VecHash{}(v); }
+    };
+
+    template <>
+    struct hash<aoc::Vec3> {
+        size_t operator()(const aoc::Vec3& v) const { return aoc::VecHash{}(v); }
+    };
+};
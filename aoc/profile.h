@@ -0,0 +1,173 @@
+#pragma once
+
+// Scoped zone profiler. Build with -DAOC_PROFILE=ON to enable it; otherwise
+// PROFILE_ZONE expands to an empty statement and none of this is compiled.
+//
+// Zones are recorded into per-thread buffers with no locking. When the process
+// exits the per-zone totals are written to stderr, and a Chrome/Perfetto trace
+// is written to $AOC_TRACE_FILE if it is set.
+
+#include "log.h"
+
+#if defined(AOC_PROFILE)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aoc::profile {
+
+    struct Event {
+        // Zone names must be string literals, only the pointer is kept
+        const char* name;
+        uint64_t start_ns;
+        uint64_t end_ns;
+    };
+
+    struct ThreadBuffer {
+        uint32_t tid;
+        std::vector<Event> events;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> threads;
+        const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    };
+
+    inline Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    inline uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - registry().epoch).count();
+    }
+
+    // Registration takes the lock once per thread, recording never does
+    inline ThreadBuffer& thread_buffer() {
+        thread_local std::shared_ptr<ThreadBuffer> buffer = []() {
+            auto& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            auto b = std::make_shared<ThreadBuffer>();
+            b->tid = static_cast<uint32_t>(r.threads.size());
+            b->events.reserve(1024);
+            r.threads.push_back(b);
+            return b;
+        }();
+        return *buffer;
+    }
+
+    class Zone {
+    public:
+        explicit Zone(const char* name)
+            : name_(name)
+            , start_(now_ns())
+        {}
+
+        ~Zone() {
+            thread_buffer().events.push_back({ name_, start_, now_ns() });
+        }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        const char* name_;
+        uint64_t start_;
+    };
+
+    struct ZoneStats {
+        uint64_t count = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+    };
+
+    // Must only be called once recording threads are idle
+    inline std::map<std::string, ZoneStats> aggregate() {
+        std::map<std::string, ZoneStats> out;
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto& t : r.threads) {
+            for (const auto& e : t->events) {
+                auto& s = out[e.name];
+                const uint64_t d = e.end_ns - e.start_ns;
+                s.count++;
+                s.total_ns += d;
+                s.max_ns = std::max(s.max_ns, d);
+            }
+        }
+        return out;
+    }
+
+    inline void write_summary(std::ostream& os) {
+        const auto stats = aggregate();
+        if (stats.empty()) { return; }
+
+        os << std::left << std::setw(24) << "zone" << std::right
+            << std::setw(10) << "count"
+            << std::setw(14) << "total ms"
+            << std::setw(14) << "mean us"
+            << std::setw(14) << "max us" << std::endl;
+        for (const auto& [name, s] : stats) {
+            os << std::left << std::setw(24) << name << std::right << std::fixed
+                << std::setw(10) << s.count
+                << std::setw(14) << std::setprecision(3) << s.total_ns * 1e-6
+                << std::setw(14) << std::setprecision(3) << s.total_ns * 1e-3 / s.count
+                << std::setw(14) << std::setprecision(3) << s.max_ns * 1e-3 << std::endl;
+        }
+    }
+
+    // Chrome trace event format, complete ("X") events with microsecond times
+    inline void write_chrome_trace(std::ostream& os) {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        os << "{\"traceEvents\":[";
+        bool first = true;
+        os << std::fixed << std::setprecision(3);
+        for (const auto& t : r.threads) {
+            for (const auto& e : t->events) {
+                os << (first ? "" : ",") << std::endl
+                    << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << t->tid
+                    << ",\"ts\":" << e.start_ns * 1e-3
+                    << ",\"dur\":" << (e.end_ns - e.start_ns) * 1e-3 << "}";
+                first = false;
+            }
+        }
+        os << std::endl << "]}" << std::endl;
+    }
+
+    struct Session {
+        Session() {
+            // Constructed first so the registry outlives this destructor
+            registry();
+        }
+
+        ~Session() {
+            write_summary(std::cerr);
+            if (const char* path = std::getenv("AOC_TRACE_FILE")) {
+                std::ofstream f(path);
+                write_chrome_trace(f);
+            }
+        }
+    };
+
+    inline Session session;
+
+};
+
+#define PROFILE_ZONE(name) ::aoc::profile::Zone CONCATENATE(aoc_profile_zone_, __LINE__)(name)
+
+#else
+
+#define PROFILE_ZONE(name) do { } while (0)
+
+#endif
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "simd.h"
+
+namespace aoc {
+
+    // Set of delimiter bytes. The bitmap answers membership for any byte. The
+    // nibble tables classify a whole vector at once with PSHUFB: a byte c is in
+    // the set when lo[c & 15] & hi[c >> 4] is non-zero. Eight bits only cover
+    // the high nibbles 0-7, so that is exact for ASCII, and sets holding bytes
+    // >= 0x80 fall back to the bitmap.
+    struct DelimiterSet {
+        uint64_t bits[4] = {};
+        uint8_t lo[16] = {};
+        uint8_t hi[16] = {};
+        size_t count = 0;
+        char first = 0;
+        bool ascii = true;
+
+        constexpr DelimiterSet() {
+            for (size_t h = 0; h < 8; h++) {
+                hi[h] = static_cast<uint8_t>(1 << h);
+            }
+        }
+
+        constexpr explicit DelimiterSet(std::string_view delims)
+            : DelimiterSet()
+        {
+            for (const char c : delims) {
+                add(c);
+            }
+        }
+
+        constexpr void add(char ch) {
+            if (contains(ch)) { return; }
+            const uint8_t c = static_cast<uint8_t>(ch);
+            bits[c >> 6] |= uint64_t(1) << (c & 63);
+            if (count++ == 0) { first = ch; }
+            if (c >= 0x80) {
+                ascii = false;
+                return;
+            }
+            lo[c & 15] |= static_cast<uint8_t>(1 << (c >> 4));
+        }
+
+        constexpr bool contains(char ch) const {
+            const uint8_t c = static_cast<uint8_t>(ch);
+            return (bits[c >> 6] >> (c & 63)) & 1;
+        }
+    };
+
+    // Delimiter sets fixed at compile time, e.g. delimiters<'\r', '\n'>
+    template <char... Delims>
+    inline constexpr DelimiterSet delimiters = []() {
+        DelimiterSet s;
+        (s.add(Delims), ...);
+        return s;
+    }();
+
+    // Offset of the first byte of s that is in set, or npos
+    constexpr size_t find_first_of(std::string_view s, const DelimiterSet& set) {
+        const char* p = s.data();
+        const size_t n = s.size();
+        // Neither memchr nor the vector paths can run in a constant expression
+        if (__builtin_is_constant_evaluated()) {
+            for (size_t i = 0; i < n; i++) {
+                if (set.contains(p[i])) { return i; }
+            }
+            return std::string_view::npos;
+        }
+        if (set.count == 0) {
+            return std::string_view::npos;
+        }
+        if (set.count == 1) {
+            const void* at = n ? std::memchr(p, set.first, n) : nullptr;
+            return at ? static_cast<const char*>(at) - p : std::string_view::npos;
+        }
+
+        size_t i = 0;
+        if (set.ascii) {
+#if defined(AOC_HAVE_AVX2)
+            const __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(set.lo)));
+            const __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(set.hi)));
+            const __m256i nibble = _mm256_set1_epi8(0x0f);
+            for (; i + 32 <= n; i += 32) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+                const __m256i l = _mm256_shuffle_epi8(lo, _mm256_and_si256(v, nibble));
+                const __m256i h = _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+                const __m256i miss = _mm256_cmpeq_epi8(_mm256_and_si256(l, h), _mm256_setzero_si256());
+                const uint32_t hit = ~static_cast<uint32_t>(_mm256_movemask_epi8(miss));
+                if (hit) {
+                    return i + simd::ctz(hit);
+                }
+            }
+#elif defined(AOC_HAVE_SSE42)
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.lo));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.hi));
+            const __m128i nibble = _mm_set1_epi8(0x0f);
+            for (; i + 16 <= n; i += 16) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                const __m128i l = _mm_shuffle_epi8(lo, _mm_and_si128(v, nibble));
+                const __m128i h = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+                const __m128i miss = _mm_cmpeq_epi8(_mm_and_si128(l, h), _mm_setzero_si128());
+                const uint32_t hit = ~static_cast<uint32_t>(_mm_movemask_epi8(miss)) & 0xffff;
+                if (hit) {
+                    return i + simd::ctz(hit);
+                }
+            }
+#endif
+        }
+        for (; i < n; i++) {
+            if (set.contains(p[i])) { return i; }
+        }
+        return std::string_view::npos;
+    }
+
+};
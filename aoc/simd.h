@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+
+#if defined(__AVX2__)
+#define AOC_HAVE_AVX2 1
+#endif
+
+#if defined(__SSE4_2__)
+#define AOC_HAVE_SSE42 1
+#endif
+
+#if defined(AOC_HAVE_AVX2) || defined(AOC_HAVE_SSE42)
+#include <immintrin.h>
+#endif
+
+namespace aoc::simd {
+
+    // Number of bytes classified per step by the block scanners
+    constexpr size_t BlockSize = 64;
+
+    inline int popcount(uint64_t v) {
+        return __builtin_popcountll(v);
+    }
+
+    // Index of the lowest set bit, v must be non-zero
+    inline int ctz(uint64_t v) {
+        return __builtin_ctzll(v);
+    }
+
+    // Clears the lowest set bit
+    inline uint64_t clear_lowest(uint64_t v) {
+        return v & (v - 1);
+    }
+
+    // Mask with the low n bits set, valid for n in [0, 64]
+    inline uint64_t low_bits(size_t n) {
+        return n >= 64 ? ~uint64_t(0) : ((uint64_t(1) << n) - 1);
+    }
+
+    // Allocator for buffers that are read with aligned vector loads
+    template <typename T, size_t Align = 64>
+    struct AlignedAllocator {
+        using value_type = T;
+
+        template <typename U>
+        struct rebind {
+            using other = AlignedAllocator<U, Align>;
+        };
+
+        AlignedAllocator() = default;
+
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U, Align>&) {}
+
+        T* allocate(size_t n) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+        }
+
+        void deallocate(T* p, size_t) {
+            ::operator delete(p, std::align_val_t(Align));
+        }
+
+        template <typename U>
+        bool operator==(const AlignedAllocator<U, Align>&) const { return true; }
+        template <typename U>
+        bool operator!=(const AlignedAllocator<U, Align>&) const { return false; }
+    };
+
+    // Rounds n up to a multiple of m
+    constexpr size_t round_up(size_t n, size_t m) {
+        return (n + m - 1) / m * m;
+    }
+
+    // Per-byte classification of a 64 byte block, bit i describes byte i
+    struct BlockMasks {
+        uint64_t digit;
+        uint64_t space;
+        uint64_t minus;
+    };
+
+#if defined(AOC_HAVE_AVX2)
+    inline uint64_t movemask64(__m256i lo, __m256i hi) {
+        const uint32_t l = static_cast<uint32_t>(_mm256_movemask_epi8(lo));
+        const uint32_t h = static_cast<uint32_t>(_mm256_movemask_epi8(hi));
+        return uint64_t(l) | (uint64_t(h) << 32);
+    }
+
+    inline BlockMasks classify_block(const char* p) {
+        const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+
+        const auto digits = [](__m256i v) {
+            // '0' <= c <= '9' as a signed range check, bytes >= 0x80 are negative
+            const __m256i gt = _mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1));
+            const __m256i lt = _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v);
+            return _mm256_and_si256(gt, lt);
+        };
+        const auto spaces = [](__m256i v) {
+            // ' ', '\t', '\n', '\v', '\f', '\r'
+            const __m256i sp = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+            const __m256i gt = _mm256_cmpgt_epi8(v, _mm256_set1_epi8('\t' - 1));
+            const __m256i lt = _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), v);
+            return _mm256_or_si256(sp, _mm256_and_si256(gt, lt));
+        };
+        const auto minus = [](__m256i v) {
+            return _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-'));
+        };
+
+        return {
+            movemask64(digits(lo), digits(hi)),
+            movemask64(spaces(lo), spaces(hi)),
+            movemask64(minus(lo), minus(hi)),
+        };
+    }
+#elif defined(AOC_HAVE_SSE42)
+    inline BlockMasks classify_block(const char* p) {
+        BlockMasks m{0, 0, 0};
+        for (size_t i = 0; i < BlockSize; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            const __m128i digit = _mm_and_si128(
+                _mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+            const __m128i space = _mm_or_si128(
+                _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                _mm_and_si128(
+                    _mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1)),
+                    _mm_cmplt_epi8(v, _mm_set1_epi8('\r' + 1))));
+            const __m128i minus = _mm_cmpeq_epi8(v, _mm_set1_epi8('-'));
+
+            m.digit |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(digit))) << i;
+            m.space |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(space))) << i;
+            m.minus |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(minus))) << i;
+        }
+        return m;
+    }
+#endif
+
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include "helpers.h"
+
+// Streaming solves: records are read incrementally from a file, a growing
+// file or stdin ("-") and folded into a day's running state, with the answers
+// so far printed every N records and/or every so many seconds.
+//
+//   DayN <file|-> --stream [--every=N] [--interval=SECONDS] [--follow]
+//
+// Any of the options implies --stream. --follow keeps reading a regular file
+// after its end, so the run only ends when killed.
+
+namespace aoc {
+
+    struct StreamOptions {
+        bool enabled = false;
+        // Records between reports, 0 for none
+        size_t every = 0;
+        // Seconds between reports, 0 for none
+        double interval = 0;
+        bool follow = false;
+    };
+
+    // Pulls the streaming options out of argv, like parse_bench_options
+    inline StreamOptions parse_stream_options(int& argc, char** argv) {
+        StreamOptions opts;
+        const auto value = [](std::string_view arg, std::string_view flag, std::string_view& out) {
+            if (arg.substr(0, flag.size()) != flag || arg.size() == flag.size() || arg[flag.size()] != '=') {
+                return false;
+            }
+            out = arg.substr(flag.size() + 1);
+            return true;
+        };
+
+        int out = 1;
+        for (int i = 1; i < argc; i++) {
+            const std::string_view arg(argv[i]);
+            std::string_view v;
+            if (arg == "--stream") {
+                opts.enabled = true;
+            } else if (arg == "--follow") {
+                opts.enabled = opts.follow = true;
+            } else if (value(arg, "--every", v)) {
+                opts.enabled = true;
+                opts.every = stoi<size_t>(v);
+            } else if (value(arg, "--interval", v)) {
+                opts.enabled = true;
+                char* end = nullptr;
+                const std::string s(v);
+                opts.interval = std::strtod(s.c_str(), &end);
+                if (s.empty() || *end || opts.interval < 0) {
+                    throw std::runtime_error("Bad value for --interval: " + s);
+                }
+            } else {
+                argv[out++] = argv[i];
+            }
+        }
+        argc = out;
+        argv[argc] = nullptr;
+        return opts;
+    }
+
+    // Feeds every token of in separated by delims to record, and calls
+    // report(records) whenever a report is due. Returns the number of records.
+    // The day prints its final answers itself once this returns.
+    template <typename Record, typename Report>
+    size_t stream_records(BlockReader& in, const DelimiterSet& delims, const StreamOptions& opts, Record&& record, Report&& report) {
+        using Clock = std::chrono::steady_clock;
+        const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opts.interval));
+        auto next = Clock::now() + interval;
+        size_t records = 0;
+
+        const auto emit = [&]() {
+            report(records);
+            next = Clock::now() + interval;
+        };
+        const auto due = [&]() {
+            return opts.interval > 0 && Clock::now() >= next;
+        };
+
+        // The clock is read once per refill of the reader rather than per
+        // record, which is often enough for a timer in seconds
+        if (opts.interval > 0 || opts.follow) {
+            in.on_wait(std::chrono::milliseconds(100), [&]() {
+                if (due()) { emit(); }
+            }, opts.follow);
+        }
+
+        std::string_view token;
+        while (in.getline(token, delims)) {
+            record(token);
+            records++;
+            if (opts.every && records % opts.every == 0) {
+                emit();
+            }
+        }
+        in.on_wait(std::chrono::milliseconds(100), nullptr);
+        return records;
+    }
+
+    const auto print_running = [](size_t records, const auto& part1, const auto& part2) {
+        out() << "Records: " << records << " Part 1: " << part1 << " Part 2: " << part2 << std::endl;
+    };
+
+};
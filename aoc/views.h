@@ -0,0 +1,197 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "helpers.h"
+
+// Lazy views for parsing pipelines. Everything is a template over the view it
+// wraps, so a chain like
+//
+//   for (const auto [a, b, c] : aoc::chunk<3>(aoc::as_ints(aoc::lines(f)))) { ... }
+//
+// inlines into a single loop over the input with no allocation. Views hand out
+// values from input iterators and end with a ViewEnd sentinel, which range-for
+// accepts in C++17. Views own copies of the views they wrap, so a chain must
+// outlive its iterators, as it does in a range-for. Everything is constexpr.
+
+namespace aoc {
+
+    struct ViewEnd {};
+
+    // Tokens of sv separated by any byte of delims, empty tokens are skipped
+    class SplitView {
+    public:
+        constexpr SplitView(std::string_view sv, const DelimiterSet& delims)
+            : sv_(sv)
+            , delims_(delims)
+        {}
+
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string_view*;
+            using reference = std::string_view;
+
+            constexpr iterator(std::string_view rest, const DelimiterSet* delims)
+                : rest_(rest)
+                , delims_(delims)
+            {
+                ++*this;
+            }
+
+            constexpr std::string_view operator*() const { return token_; }
+
+            constexpr iterator& operator++() {
+                done_ = !getline(rest_, token_, *delims_);
+                return *this;
+            }
+
+            constexpr bool operator==(ViewEnd) const { return done_; }
+            constexpr bool operator!=(ViewEnd) const { return !done_; }
+
+        private:
+            std::string_view rest_;
+            std::string_view token_;
+            const DelimiterSet* delims_;
+            bool done_ = false;
+        };
+
+        constexpr iterator begin() const { return iterator(sv_, &delims_); }
+        constexpr ViewEnd end() const { return {}; }
+
+    private:
+        std::string_view sv_;
+        DelimiterSet delims_;
+    };
+
+    constexpr SplitView split(std::string_view sv, std::string_view delims) {
+        return SplitView(sv, DelimiterSet(delims));
+    }
+
+    template <char... Delims>
+    constexpr SplitView split(std::string_view sv) {
+        return SplitView(sv, delimiters<Delims...>);
+    }
+
+    // Non-empty lines, either line ending
+    constexpr SplitView lines(std::string_view sv) {
+        return split<'\r', '\n'>(sv);
+    }
+
+    // Each token of view converted to Int, throws on anything that is not one
+    // or does not fit
+    template <typename View, typename Int>
+    class AsIntsView {
+    public:
+        constexpr explicit AsIntsView(View view)
+            : view_(std::move(view))
+        {}
+
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = Int;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Int*;
+            using reference = Int;
+
+            constexpr explicit iterator(typename View::iterator it)
+                : it_(std::move(it))
+            {}
+
+            constexpr Int operator*() const { return stoi<Int>(*it_); }
+
+            constexpr iterator& operator++() {
+                ++it_;
+                return *this;
+            }
+
+            constexpr bool operator==(ViewEnd e) const { return it_ == e; }
+            constexpr bool operator!=(ViewEnd e) const { return it_ != e; }
+
+        private:
+            typename View::iterator it_;
+        };
+
+        constexpr iterator begin() const { return iterator(view_.begin()); }
+        constexpr ViewEnd end() const { return {}; }
+
+    private:
+        View view_;
+    };
+
+    template <typename Int = int64_t, typename View>
+    constexpr AsIntsView<View, Int> as_ints(View view) {
+        return AsIntsView<View, Int>(std::move(view));
+    }
+
+    // Consecutive groups of N values of view as std::array, a trailing group
+    // shorter than N is dropped
+    template <size_t N, typename View>
+    class ChunkView {
+    public:
+        using element_type = std::decay_t<decltype(*std::declval<const typename View::iterator&>())>;
+
+        constexpr explicit ChunkView(View view)
+            : view_(std::move(view))
+        {}
+
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = std::array<element_type, N>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+
+            constexpr explicit iterator(typename View::iterator it)
+                : it_(std::move(it))
+            {
+                ++*this;
+            }
+
+            constexpr const value_type& operator*() const { return chunk_; }
+
+            constexpr iterator& operator++() {
+                for (size_t i = 0; i < N; i++) {
+                    if (it_ == ViewEnd{}) {
+                        done_ = true;
+                        break;
+                    }
+                    chunk_[i] = *it_;
+                    ++it_;
+                }
+                return *this;
+            }
+
+            constexpr bool operator==(ViewEnd) const { return done_; }
+            constexpr bool operator!=(ViewEnd) const { return !done_; }
+
+        private:
+            typename View::iterator it_;
+            value_type chunk_{};
+            bool done_ = false;
+        };
+
+        constexpr iterator begin() const { return iterator(view_.begin()); }
+        constexpr ViewEnd end() const { return {}; }
+
+    private:
+        View view_;
+    };
+
+    template <size_t N, typename View>
+    constexpr ChunkView<N, View> chunk(View view) {
+        static_assert(N > 0, "chunk size must be positive");
+        return ChunkView<N, View>(std::move(view));
+    }
+
+};
@@ -39,6 +39,10 @@ if [[ $# > 0 ]]; then
             ;;
         run)
             shift
+            # All days in one process when the runner is installed
+            if [ -x "${BUILD_DIR}/bin/runner" ]; then
+                exec "${BUILD_DIR}/bin/runner" --inputs="${ROOT_DIR}/inputs" "$@"
+            fi
             if [[ $# = 0 ]]; then
                 for f in ${BUILD_DIR}/bin/Day*; do
                     day=$(basename "${f}")
@@ -51,13 +55,41 @@ if [[ $# > 0 ]]; then
             fi
             exit 0
             ;;
+        bench)
+            # Runs every day over generated inputs of increasing size
+            shift
+            sizes="${*:-64K 1M 16M 256M}"
+            bench_dir="${BUILD_DIR}/bench"
+            mkdir -p "${bench_dir}"
+            printf "%-6s %8s %14s %12s %12s %14s\n" day size bytes median_ms MB/s records/s
+            for f in ${BUILD_DIR}/bin/Day*; do
+                day=$(basename "${f}")
+                for size in ${sizes}; do
+                    input="${bench_dir}/${day}-${size}.txt"
+                    if [ ! -e "${input}" ]; then
+                        "${BUILD_DIR}/bin/generate" "${day}" "${size}" -o "${input}" 2> "${input}.records"
+                    fi
+                    records=$(sed -n 's/^records=\([0-9]*\).*/\1/p' "${input}.records")
+                    "${f}" --bench --json="${bench_dir}/${day}-${size}.json" "${input}" > /dev/null
+                    json=$(cat "${bench_dir}/${day}-${size}.json")
+                    bytes=$(echo "${json}" | sed -n 's/.*"bytes":\([0-9]*\).*/\1/p')
+                    median=$(echo "${json}" | sed -n 's/.*"median_ns":\([0-9]*\).*/\1/p')
+                    awk -v day="${day}" -v size="${size}" -v bytes="${bytes}" -v ns="${median}" -v records="${records}" 'BEGIN {
+                        s = ns / 1e9
+                        printf "%-6s %8s %14d %12.3f %12.1f %14.0f\n", day, size, bytes, ns / 1e6, bytes / s / 1e6, records / s
+                    }'
+                done
+            done
+            exit 0
+            ;;
         *)
             echo "Build type must be one of:"
             echo "  clean     - Clean build output"
             echo "  release   - builds release, coverage and asan targets"
             echo "  debug     - (default) Disable optimizations and enable debug options"
             echo "  new [num] - Prepare for a new day from an empty template"
-            echo "  run (day) - Run the executables, optionally run specific day"
+            echo "  run (days) - Run all days concurrently in one process, optionally specific days"
+            echo "  bench (sizes) - Benchmark every day over generated inputs, e.g. 64K 1M 1G"
             exit 1
     esac
 fi
@@ -1,4 +1,6 @@
 #include "aoc/helpers.h"
+#include "aoc/bench.h"
+#include "aoc/views.h"
 
 namespace {
   using Result = std::pair<int, int>;
@@ -8,26 +10,39 @@ namespace {
   constexpr int SR_Part1 = 0;
   constexpr int SR_Part2 = 0;
 
-  const auto LoadInput = [](auto f) {
+  // Kept usable in a constant expression so the sample answers are checked at
+  // compile time; if LoadInput outgrows it, keep this as the scalar reference
+  constexpr Result SolveSmall(std::string_view f) {
     Result r{0, 0};
-    std::string_view line;
-    while (aoc::getline(f, line)) {
+    for ([[maybe_unused]] const auto line : aoc::lines(f)) {
       
     }
     return r;
+  }
+
+  static_assert(SolveSmall(SampleInput) == Result{ SR_Part1, SR_Part2 });
+
+  const auto LoadInput = [](auto f) {
+    PROFILE_ZONE("LoadInput");
+    return SolveSmall(f);
   };
 }
 
-int main(int argc, char** argv) {
+AOC_MAIN(int argc, char** argv) {
   aoc::AutoTimer t;
+  const auto bench = aoc::parse_bench_options(argc, argv);
   const bool inTest = argc < 2;
 
   Result r;
   if (inTest) {
     r = LoadInput(SampleInput);
   } else {
-    std::unique_ptr<MappedFileSource>m(new MappedFileSource(argc, argv));
-    std::string_view f(m->data(), m->size());
+    MappedFileSource m(argc, argv);
+    std::string_view f(m.data(), m.size());
+    t.set_bytes(f.size());
+    if (bench.enabled) {
+      aoc::run_benchmark(aoc::bench_name(argv[0]), bench, f.size(), [&f]() { return LoadInput(f); });
+    }
     r = LoadInput(f);
   }
 
@@ -38,10 +53,13 @@ int main(int argc, char** argv) {
 
   aoc::print_results(part1, part2);
 
+#if !defined(NDEBUG)
+  // The sample is checked at compile time, this covers the production path
   if (inTest) {
     aoc::assert_result(part1, SR_Part1);
     aoc::assert_result(part2, SR_Part2);
   }
+#endif
 
   return 0;
 }
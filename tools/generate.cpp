@@ -0,0 +1,196 @@
+#include "aoc/helpers.h"
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <vector>
+
+// Writes deterministic, valid puzzle inputs of a requested size.
+//
+//   generate <day> <size>[K|M|G] [--seed=N] [-o FILE]
+//
+// The number of records written goes to stderr as `records=N bytes=N`.
+
+namespace {
+
+  // splitmix64, small and good enough for synthetic inputs
+  class Rng {
+  public:
+    explicit Rng(uint64_t seed)
+      : state_(seed)
+    {}
+
+    uint64_t next() {
+      uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+
+    // Uniform enough in [lo, hi] for the small ranges used here
+    int64_t range(int64_t lo, int64_t hi) {
+      return lo + static_cast<int64_t>(next() % static_cast<uint64_t>(hi - lo + 1));
+    }
+
+  private:
+    uint64_t state_;
+  };
+
+  class Output {
+  public:
+    explicit Output(FILE* f)
+      : f_(f)
+    {
+      buf_.reserve(Capacity);
+    }
+
+    ~Output() {
+      flush();
+    }
+
+    void write(std::string_view s) {
+      if (buf_.size() + s.size() > Capacity) { flush(); }
+      buf_.append(s);
+      bytes_ += s.size();
+    }
+
+    size_t bytes() const { return bytes_; }
+
+  private:
+    static constexpr size_t Capacity = 1 << 20;
+
+    void flush() {
+      if (!buf_.empty() && std::fwrite(buf_.data(), 1, buf_.size(), f_) != buf_.size()) {
+        throw std::runtime_error("write failed");
+      }
+      buf_.clear();
+    }
+
+    FILE* f_;
+    std::string buf_;
+    size_t bytes_ = 0;
+  };
+
+  // "R123, L45, ..." on a single line
+  size_t GenerateDay1(Output& out, Rng& rng, size_t size) {
+    size_t records = 0;
+    while (out.bytes() < size) {
+      std::string s = records ? ", " : "";
+      s += rng.next() & 1 ? 'R' : 'L';
+      s += std::to_string(rng.range(1, 10000));
+      out.write(s);
+      records++;
+    }
+    out.write("\n");
+    return records;
+  }
+
+  // Lines of 100 to 1000 U, D, L and R
+  size_t GenerateDay2(Output& out, Rng& rng, size_t size) {
+    constexpr std::string_view Moves = "UDLR";
+    size_t records = 0;
+    std::string line;
+    while (out.bytes() < size) {
+      line.clear();
+      const int64_t n = rng.range(100, 1000);
+      for (int64_t i = 0; i < n; i++) {
+        line += Moves[rng.next() & 3];
+      }
+      line += '\n';
+      out.write(line);
+      records++;
+    }
+    return records;
+  }
+
+  // Right aligned triples of sides, in whole groups of three rows for part 2
+  size_t GenerateDay3(Output& out, Rng& rng, size_t size) {
+    size_t records = 0;
+    char row[32];
+    while (out.bytes() < size || records % 3) {
+      const int n = snprintf(row, sizeof(row), "%5d%5d%5d\n",
+        static_cast<int>(rng.range(1, 999)), static_cast<int>(rng.range(1, 999)), static_cast<int>(rng.range(1, 999)));
+      out.write(std::string_view(row, n));
+      records++;
+    }
+    return records;
+  }
+
+  const std::map<std::string_view, std::function<size_t(Output&, Rng&, size_t)>> Generators{
+    { "Day1", GenerateDay1 },
+    { "Day2", GenerateDay2 },
+    { "Day3", GenerateDay3 },
+  };
+
+  size_t ParseSize(std::string_view s) {
+    size_t scale = 1;
+    if (!s.empty()) {
+      switch (s.back()) {
+        case 'K': case 'k': scale = size_t(1) << 10; break;
+        case 'M': case 'm': scale = size_t(1) << 20; break;
+        case 'G': case 'g': scale = size_t(1) << 30; break;
+      }
+      if (scale > 1) { s.remove_suffix(1); }
+    }
+    if (!aoc::is_numeric(s) || s[0] == '-') {
+      throw std::runtime_error("Bad size: " + std::string(s));
+    }
+    return aoc::stoi(s) * scale;
+  }
+
+  int Usage() {
+    std::cerr << "usage: generate <day> <size>[K|M|G] [--seed=N] [-o FILE]" << std::endl;
+    std::cerr << "days:";
+    for (const auto& g : Generators) {
+      std::cerr << " " << g.first;
+    }
+    std::cerr << std::endl;
+    return 1;
+  }
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  uint64_t seed = 2016;
+  const char* path = nullptr;
+  std::vector<std::string_view> positional;
+  for (size_t i = 0; i < args.size(); i++) {
+    if (aoc::starts_with(args[i], "--seed=")) {
+      seed = aoc::stoi(args[i].substr(7));
+    } else if (args[i] == "-o" && i + 1 < args.size()) {
+      path = argv[++i + 1];
+    } else {
+      positional.push_back(args[i]);
+    }
+  }
+  if (positional.size() != 2) {
+    return Usage();
+  }
+
+  std::string day(positional[0]);
+  if (aoc::is_numeric(day)) {
+    day = "Day" + day;
+  }
+  const auto g = Generators.find(day);
+  if (g == Generators.end()) {
+    return Usage();
+  }
+
+  FILE* f = path ? std::fopen(path, "wb") : stdout;
+  if (!f) {
+    throw std::runtime_error("Unable to open " + std::string(path));
+  }
+
+  Rng rng(seed);
+  size_t records = 0;
+  size_t bytes = 0;
+  {
+    Output out(f);
+    records = g->second(out, rng, ParseSize(positional[1]));
+    bytes = out.bytes();
+  }
+  if (path) {
+    std::fclose(f);
+  }
+  std::cerr << "records=" << records << " bytes=" << bytes << std::endl;
+  return 0;
+}
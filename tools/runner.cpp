@@ -0,0 +1,131 @@
+#include "aoc/helpers.h"
+#include "aoc/parallel.h"
+#include <algorithm>
+#include <vector>
+
+// Runs every registered day, or the listed ones, in a single process.
+//
+//   runner [--inputs=DIR] [--threads=N] [day ...]
+//
+// Days run concurrently on a pool of their own, each reading DIR/<day>.txt.
+// --threads defaults to $AOC_THREADS, like the pool the days use themselves.
+// Output is captured per day and printed in day order as soon as each day and
+// all the days before it have finished.
+
+namespace {
+
+  struct Outcome {
+    std::string output;
+    double seconds;
+    int status;
+  };
+
+  // Day2 sorts before Day10
+  size_t DayNumber(std::string_view name) {
+    while (!name.empty() && !aoc::is_numeric(name.front())) {
+      name.remove_prefix(1);
+    }
+    return aoc::is_numeric(name) ? static_cast<size_t>(aoc::stoi(name)) : 0;
+  }
+
+  Outcome RunDay(const aoc::DayEntry& day, const std::string& input) {
+    std::ostringstream os;
+    aoc::out_stream() = &os;
+
+    std::string name(day.name);
+    std::string path(input);
+    char* argv[] = { name.data(), path.data(), nullptr };
+
+    const auto start = std::chrono::steady_clock::now();
+    int status = 0;
+    try {
+      status = day.main(2, argv);
+    } catch (const std::exception& e) {
+      os << "Error: " << e.what() << std::endl;
+      status = 1;
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    aoc::out_stream() = &std::cout;
+    return { os.str(), std::chrono::duration<double>(end - start).count(), status };
+  }
+
+  int Usage() {
+    std::cerr << "usage: runner [--inputs=DIR] [--threads=N] [day ...]" << std::endl;
+    std::cerr << "days:";
+    for (const auto& d : aoc::day_registry()) {
+      std::cerr << " " << d.name;
+    }
+    std::cerr << std::endl;
+    return 1;
+  }
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  std::string inputs(AOC_INPUTS_DIR);
+  size_t threads = aoc::default_thread_count();
+  std::vector<std::string_view> positional;
+  for (const auto arg : args) {
+    if (aoc::starts_with(arg, "--inputs=")) {
+      inputs = std::string(arg.substr(9));
+    } else if (aoc::starts_with(arg, "--threads=")) {
+      int64_t n = 0;
+      if (aoc::parse_int(arg.substr(10), n) != aoc::ParseStatus::Ok || n < 1) {
+        return Usage();
+      }
+      threads = static_cast<size_t>(n);
+    } else if (aoc::starts_with(arg, "-")) {
+      return Usage();
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  auto registered = aoc::day_registry();
+  std::sort(registered.begin(), registered.end(), [](const auto& a, const auto& b) {
+    return DayNumber(a.name) < DayNumber(b.name);
+  });
+
+  std::vector<aoc::DayEntry> days;
+  if (positional.empty()) {
+    days = registered;
+  }
+  for (const auto p : positional) {
+    std::string name(p);
+    if (aoc::is_numeric(name)) {
+      name = "Day" + name;
+    }
+    const auto d = std::find_if(registered.begin(), registered.end(), [&name](const auto& e) { return name == e.name; });
+    if (d == registered.end()) {
+      return Usage();
+    }
+    days.push_back(*d);
+  }
+
+  aoc::AutoTimer t("total");
+
+  // Days use the default pool for their own work and block on it, so they
+  // must not be queued on it themselves
+  aoc::ThreadPool pool(std::min(threads, std::max<size_t>(1, days.size())));
+  std::vector<std::future<Outcome>> pending;
+  pending.reserve(days.size());
+  for (const auto& d : days) {
+    pending.push_back(pool.submit([&d, &inputs]() { return RunDay(d, inputs + "/" + d.name + ".txt"); }));
+  }
+
+  int failed = 0;
+  double serial = 0;
+  for (size_t i = 0; i < days.size(); i++) {
+    const auto o = pending[i].get();
+    std::cout << days[i].name << std::endl << o.output;
+    std::cout << days[i].name << ": " << std::fixed << std::setprecision(6) << o.seconds << " sec"
+      << (o.status ? " FAILED" : "") << std::endl << std::endl;
+    serial += o.seconds;
+    failed += o.status != 0;
+  }
+
+  std::cout << "Days: " << days.size() << " Failed: " << failed
+    << " Sum of day times: " << std::fixed << std::setprecision(6) << serial << " sec" << std::endl;
+  return failed ? 1 : 0;
+}